@@ -1287,6 +1287,8 @@ bool bitmap_ior(bitmap dst, const_bitmap a, const_bitmap b) {
     dst_elt = *dst_prev_pnext;
   }
 
+  /* Ensure that dst->current is valid.  */
+  dst->current = dst->first;
   if (dst_elt) {
     changed = true;
     bitmap_elt_clear_from(dst, dst_elt);
@@ -1586,6 +1588,8 @@ bool bitmap_ior_and_compl(bitmap dst, const_bitmap a, const_bitmap b,
     }
   }
 
+  /* Ensure that dst->current is valid.  */
+  dst->current = dst->first;
   if (dst_elt) {
     changed = true;
     bitmap_elt_clear_from(dst, dst_elt);
@@ -714,6 +714,10 @@ int c_common_handle_option(size_t scode, const char *arg, int value) {
       flag_optional_diags = value;
       break;
 
+    case OPT_fpack_columns:
+      line_table->pack_columns = value;
+      break;
+
     case OPT_fpch_deps:
       cpp_opts->restore_pch_deps = value;
       break;
@@ -770,6 +774,10 @@ int c_common_handle_option(size_t scode, const char *arg, int value) {
       cpp_opts->input_charset = arg;
       break;
 
+    case OPT_finclude_cache_:
+      cpp_opts->include_cache_file = arg;
+      break;
+
     case OPT_ftemplate_depth_:
       max_tinst_depth = value;
       break;
@@ -1346,6 +1354,11 @@ static void sanitize_cpp_opts(void) {
   } else if (cpp_opts->deps.missing_files)
     error("-MG may only be used with -M or -MM");
 
+  /* Skipping a header by a guard found in the include cache would drop
+     its linemarkers, making the preprocessed text depend on the cache.  */
+  if (flag_preprocess_only && !flag_no_output)
+    cpp_opts->include_cache_guards = 0;
+
   cpp_opts->unsigned_char = !flag_signed_char;
   cpp_opts->stdc_0_in_system_headers = STDC_0_IN_SYSTEM_HEADERS;
 
@@ -35,6 +35,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "hosthooks.h"
 #include "target.h"
 #include "opts.h"
+#include "md5.h"
 
 /* This is a list of flag variables that must match exactly, and their
    names for the error message.  The possible values for *flag_var must
@@ -65,20 +66,43 @@ struct c_pch_validity {
   signed char match[MATCH_SIZE];
   void (*pch_init)(void);
   size_t target_data_length;
+  unsigned char pch_id[16];
 };
 
+/* A PCH file written with -fpch-chain over another one names it, and
+   records where in it its c_pch_header is.  The name follows this
+   structure.  */
+
 struct c_pch_header {
   unsigned long asm_size;
+  unsigned long base_name_length;
+  long base_header_offset;
+  unsigned char base_id[16];
 };
 
 #define IDENT_LENGTH 8
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
 /* The file we'll be writing the PCH to.  */
 static FILE *pch_outfile;
 
 /* The position in the assembler output file when pch_init was called.  */
 static long asm_file_startpos;
 
+/* The identity of the PCH file being written.  */
+static unsigned char pch_outfile_id[16];
+
+/* The PCH file read in this compilation, which a PCH file written with
+   -fpch-chain is a layer over.  */
+static struct {
+  char *name;
+  long header_offset;
+  unsigned char id[16];
+} pch_base;
+
 static const char *get_ident(void);
 
 /* Compute an appropriate 8-byte magic number for the PCH file, so that
@@ -88,7 +112,7 @@ static const char *get_ident(void);
 
 static const char *get_ident(void) {
   static char result[IDENT_LENGTH];
-  static const char templ[IDENT_LENGTH] = "gpch.013";
+  static const char templ[IDENT_LENGTH] = "gpch.015";
   static const char c_language_chars[] = "Co+O";
 
   memcpy(result, templ, IDENT_LENGTH);
@@ -135,6 +159,23 @@ void pch_init(void) {
     }
   }
   v.pch_init = &pch_init;
+  {
+    /* Give each PCH file an identity, so that a layer can tell whether
+       the file it was written over has been replaced.  */
+    struct {
+      unsigned local_tick;
+      long pid;
+    } seed;
+    struct md5_ctx ctx;
+
+    seed.local_tick = local_tick;
+    seed.pid = (long)getpid();
+    md5_init_ctx(&ctx);
+    md5_process_bytes(&seed, sizeof(seed), &ctx);
+    md5_process_bytes(pch_file, strlen(pch_file), &ctx);
+    md5_finish_ctx(&ctx, pch_outfile_id);
+    memcpy(v.pch_id, pch_outfile_id, 16);
+  }
   target_validity = targetm.get_pch_validity(&v.target_data_length);
 
   if (fwrite(partial_pch, IDENT_LENGTH, 1, f) != 1 ||
@@ -171,8 +212,18 @@ void c_common_write_pch(void) {
 
   asm_file_end = ftell(asm_out_file);
   h.asm_size = asm_file_end - asm_file_startpos;
+  h.base_name_length = 0;
+  h.base_header_offset = 0;
+  memset(h.base_id, 0, sizeof(h.base_id));
+  if (flag_pch_chain && pch_base.name) {
+    h.base_name_length = strlen(pch_base.name);
+    h.base_header_offset = pch_base.header_offset;
+    memcpy(h.base_id, pch_base.id, sizeof(h.base_id));
+  }
 
-  if (fwrite(&h, sizeof(h), 1, pch_outfile) != 1)
+  if (fwrite(&h, sizeof(h), 1, pch_outfile) != 1 ||
+      (h.base_name_length != 0 &&
+       fwrite(pch_base.name, h.base_name_length, 1, pch_outfile) != 1))
     fatal_error("can%'t write %s: %m", pch_file);
 
   buf = XNEWVEC(char, 16384);
@@ -196,7 +247,7 @@ void c_common_write_pch(void) {
   if (fseek(asm_out_file, 0, SEEK_END) != 0)
     fatal_error("can%'t seek in %s: %m", asm_file_name);
 
-  gt_pch_save(pch_outfile);
+  gt_pch_save(pch_outfile, h.base_name_length != 0);
   cpp_write_pch_state(parse_in, pch_outfile);
 
   if (fseek(pch_outfile, 0, SEEK_SET) != 0 ||
@@ -206,6 +257,58 @@ void c_common_write_pch(void) {
   fclose(pch_outfile);
 }
 
+/* Read the name of the PCH file that the one open on FD, whose header
+   H has just been read, is a layer over.  Return NULL if it is not a
+   layer.  */
+
+static char *read_pch_base_name(int fd, const struct c_pch_header *h) {
+  char *base_name;
+
+  if (h->base_name_length == 0)
+    return NULL;
+  base_name = XNEWVEC(char, h->base_name_length + 1);
+  if ((size_t)read(fd, base_name, h->base_name_length) !=
+      h->base_name_length) {
+    free(base_name);
+    return NULL;
+  }
+  base_name[h->base_name_length] = '\0';
+  return base_name;
+}
+
+/* Return true if the PCH file BASE_NAME is still the one with identity
+   BASE_ID whose header is at HEADER_OFFSET, and so are the files it is
+   a layer over in turn.  */
+
+static bool pch_base_valid_p(const char *base_name,
+                             const unsigned char *base_id,
+                             long header_offset) {
+  int fd;
+  struct c_pch_validity v;
+  struct c_pch_header h;
+  char *next_name;
+  bool ok;
+
+  fd = open(base_name, O_RDONLY | O_BINARY, 0666);
+  if (fd == -1)
+    return false;
+
+  ok = (lseek(fd, IDENT_LENGTH + 16, SEEK_SET) != -1 &&
+        read(fd, &v, sizeof(v)) == sizeof(v) &&
+        memcmp(v.pch_id, base_id, 16) == 0 &&
+        lseek(fd, header_offset, SEEK_SET) == header_offset &&
+        read(fd, &h, sizeof(h)) == sizeof(h));
+  if (ok && h.base_name_length != 0) {
+    next_name = read_pch_base_name(fd, &h);
+    ok = (next_name != NULL &&
+          pch_base_valid_p(next_name, h.base_id, h.base_header_offset));
+    free(next_name);
+  }
+
+  close(fd);
+  return ok;
+}
+
 /* Check the PCH file called NAME, open on FD, to see if it can be
    used in this compilation.  Return 1 if valid, 0 if the file can't
    be used now but might be if it's seen later in the compilation, and
@@ -323,8 +426,70 @@ int c_common_valid_pch(cpp_reader *pfile, const char *name, int fd) {
   result = cpp_valid_state(pfile, name, fd);
   if (result == -1)
     return 2;
-  else
-    return result == 0;
+  if (result != 0)
+    return 0;
+
+  /* A layer is only valid over the very file it was written over.  */
+  {
+    off_t header_offset = lseek(fd, 0, SEEK_CUR);
+    struct c_pch_header h;
+    char *base_name;
+    bool ok = true;
+
+    if (header_offset == -1 || read(fd, &h, sizeof(h)) != sizeof(h))
+      fatal_error("can%'t read %s: %m", name);
+    if (h.base_name_length != 0) {
+      base_name = read_pch_base_name(fd, &h);
+      if (base_name == NULL)
+        fatal_error("can%'t read %s: %m", name);
+      ok = pch_base_valid_p(base_name, h.base_id, h.base_header_offset);
+      if (!ok && cpp_get_options(pfile)->warn_invalid_pch)
+        cpp_error(pfile, CPP_DL_WARNING,
+                  "%s: precompiled header %s it was built over has changed",
+                  name, base_name);
+      free(base_name);
+    }
+    if (lseek(fd, header_offset, SEEK_SET) != header_offset)
+      fatal_error("can%'t seek in %s: %m", name);
+    if (!ok)
+      return 2;
+  }
+
+  return 1;
+}
+
+/* Read in the GC objects of the PCH file NAME, whose header is at
+   HEADER_OFFSET, after those of the files it is a layer over.  KEEP is
+   passed to gt_pch_restore.  */
+
+static void read_pch_base(const char *name, long header_offset, bool keep) {
+  FILE *f;
+  struct c_pch_header h;
+
+  f = fopen(name, "rb");
+  if (f == NULL)
+    fatal_error("can%'t open %s: %m", name);
+  if (fseek(f, header_offset, SEEK_SET) != 0 ||
+      fread(&h, sizeof(h), 1, f) != 1)
+    fatal_error("can%'t read %s: %m", name);
+
+  if (h.base_name_length != 0) {
+    char *base_name = XNEWVEC(char, h.base_name_length + 1);
+
+    if (fread(base_name, h.base_name_length, 1, f) != 1)
+      fatal_error("can%'t read %s: %m", name);
+    base_name[h.base_name_length] = '\0';
+    read_pch_base(base_name, h.base_header_offset, keep);
+    free(base_name);
+  }
+
+  /* The assembler output of a layer already includes that of the
+     files below it.  */
+  if (fseek(f, h.asm_size, SEEK_CUR) != 0)
+    fatal_error("can%'t seek in %s: %m", name);
+
+  gt_pch_restore(f, keep);
+  fclose(f);
 }
 
 /* If non-NULL, this function is called after a precompile header file
@@ -341,6 +506,9 @@ void c_common_read_pch(cpp_reader *pfile, const char *name, int fd,
   struct save_macro_data *smd;
   expanded_location saved_loc;
   bool saved_trace_includes;
+  long header_offset;
+  char *base_name = NULL;
+  bool keep = flag_pch_chain && pch_file != NULL;
 
   f = fdopen(fd, "rb");
   if (f == NULL) {
@@ -351,12 +519,24 @@ void c_common_read_pch(cpp_reader *pfile, const char *name, int fd,
 
   cpp_get_callbacks(parse_in)->valid_pch = NULL;
 
-  if (fread(&h, sizeof(h), 1, f) != 1) {
+  header_offset = ftell(f);
+  if (header_offset == -1 || fread(&h, sizeof(h), 1, f) != 1) {
     cpp_errno(pfile, CPP_DL_ERROR, "reading");
     fclose(f);
     return;
   }
 
+  if (h.base_name_length != 0) {
+    base_name = XNEWVEC(char, h.base_name_length + 1);
+    if (fread(base_name, h.base_name_length, 1, f) != 1) {
+      cpp_errno(pfile, CPP_DL_ERROR, "reading");
+      free(base_name);
+      fclose(f);
+      return;
+    }
+    base_name[h.base_name_length] = '\0';
+  }
+
   if (!flag_preprocess_only) {
     unsigned long written;
     char *buf = XNEWVEC(char, 16384);
@@ -384,13 +564,35 @@ void c_common_read_pch(cpp_reader *pfile, const char *name, int fd,
 
   cpp_prepare_state(pfile, &smd);
 
-  gt_pch_restore(f);
+  /* A layer is read over the files it was written over; only its own
+     macro state is needed, as it includes theirs.  */
+  if (base_name) {
+    read_pch_base(base_name, h.base_header_offset, keep);
+    free(base_name);
+  }
+
+  gt_pch_restore(f, keep);
 
   if (cpp_read_state(pfile, name, f, smd) != 0) {
     fclose(f);
     return;
   }
 
+  /* Remember the file, so that a PCH file written by this compilation
+     can be a layer over it.  */
+  if (keep) {
+    struct c_pch_validity v;
+
+    if (fseek(f, IDENT_LENGTH + 16, SEEK_SET) != 0 ||
+        fread(&v, sizeof(v), 1, f) != 1)
+      cpp_errno(pfile, CPP_DL_ERROR, "reading");
+    else {
+      pch_base.name = lrealpath(name);
+      pch_base.header_offset = header_offset;
+      memcpy(pch_base.id, v.pch_id, sizeof(pch_base.id));
+    }
+  }
+
   fclose(f);
 
   line_table->trace_includes = saved_trace_includes;
@@ -414,10 +616,6 @@ void c_common_no_more_pch(void) {
 
 /* Handle #pragma GCC pch_preprocess, to load in the PCH file.  */
 
-#ifndef O_BINARY
-#define O_BINARY 0
-#endif
-
 void c_common_pch_pragma(cpp_reader *pfile, const char *name) {
   int fd;
 
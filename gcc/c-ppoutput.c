@@ -79,10 +79,17 @@ void preprocess_file(cpp_reader *pfile) {
   /* A successful cpp_read_main_file guarantees that we can call
      cpp_scan_nooutput or cpp_get_token next.  */
   if (flag_no_output) {
-    /* Scan -included buffers, then the main file.  */
-    while (pfile->buffer->prev)
+    /* With -fdirectives-only, dependency output needs nothing but the
+       directives, so the text between them is not lexed.  */
+    if (cpp_get_options(pfile)->directives_only &&
+        !cpp_get_options(pfile)->preprocessed)
+      cpp_scan_directives_only(pfile);
+    else {
+      /* Scan -included buffers, then the main file.  */
+      while (pfile->buffer->prev)
+        cpp_scan_nooutput(pfile);
       cpp_scan_nooutput(pfile);
-    cpp_scan_nooutput(pfile);
+    }
   } else if (cpp_get_options(pfile)->traditional)
     scan_translation_unit_trad(pfile);
   else if (cpp_get_options(pfile)->directives_only &&
@@ -1145,6 +1145,13 @@ void cgraph_optimize(void) {
     fprintf(stderr, "Memory consumption after IPA\n");
     dump_memory_report(false);
   }
+
+  /* Much of what IPA allocated is dead by now.  Collect it, and let the
+     RTL passes fill the pages that are still dense.  */
+  if (PARAM_VALUE(GGC_PREFER_DENSE_PAGES)) {
+    ggc_collect();
+    ggc_prefer_dense_pages();
+  }
   timevar_pop(TV_CGRAPHOPT);
 
   /* Output everything.  */
@@ -104,6 +104,10 @@ along with GCC; see the file COPYING3.  If not see
 #define NM_FLAGS "-n"
 #endif
 
+#ifdef HAVE_MMAP_FILE
+#include <sys/mman.h>
+#endif
+
 #endif /* OBJECT_FORMAT_NONE */
 
 /* Some systems use __main in a way incompatible with its use in gcc, in these
@@ -1916,6 +1920,286 @@ static void write_aix_file(FILE *stream, struct id *list) {
 
 #ifdef OBJECT_FORMAT_NONE
 
+/* Add NAME, a symbol found in PROG_NAME during WHICH_PASS, to the list
+   it belongs in.  Return false if it is not a constructor, destructor
+   or frame table.  */
+
+static bool note_ctor_dtor(const char *name, const char *prog_name,
+                           enum pass which_pass) {
+  switch (is_ctor_dtor(name)) {
+    case SYM_CTOR:
+      if (which_pass != PASS_LIB)
+        add_to_list(&constructors, name);
+      return true;
+
+    case SYM_DTOR:
+      if (which_pass != PASS_LIB)
+        add_to_list(&destructors, name);
+      return true;
+
+    case SYM_INIT:
+      if (which_pass != PASS_LIB)
+        fatal("init function found in object %s", prog_name);
+#ifndef LD_INIT_SWITCH
+      add_to_list(&constructors, name);
+#endif
+      return true;
+
+    case SYM_FINI:
+      if (which_pass != PASS_LIB)
+        fatal("fini function found in object %s", prog_name);
+#ifndef LD_FINI_SWITCH
+      add_to_list(&destructors, name);
+#endif
+      return true;
+
+    case SYM_DWEH:
+      if (which_pass != PASS_LIB)
+        add_to_list(&frame_tables, name);
+      return true;
+
+    default: /* not a constructor or destructor */
+      return false;
+  }
+}
+
+/* Reading ELF symbol tables directly, which saves running nm on ELF
+   objects, archives of them, and executables.  Only the fields the
+   scan needs are decoded, from either byte order and either class, so
+   that a cross collect2 can read its target's files.  Anything that is
+   not understood makes the caller fall back to nm.  */
+
+/* An ELF file image in memory.  */
+struct elf_image {
+  const unsigned char *data;
+  size_t size;
+  bool is64;
+  bool big_endian;
+};
+
+/* Read the SIZE-byte field at OFFSET of IMAGE.  The caller has checked
+   the bounds.  */
+
+static unsigned HOST_WIDEST_INT elf_field(const struct elf_image *image,
+                                          size_t offset, int size) {
+  const unsigned char *p = image->data + offset;
+  unsigned HOST_WIDEST_INT value = 0;
+  int i;
+
+  if (image->big_endian)
+    for (i = 0; i < size; i++)
+      value = (value << 8) | p[i];
+  else
+    for (i = size - 1; i >= 0; i--)
+      value = (value << 8) | p[i];
+  return value;
+}
+
+/* Return true if the LENGTH bytes at OFFSET lie within SIZE bytes.  */
+
+static inline bool elf_in_bounds(unsigned HOST_WIDEST_INT offset,
+                                 unsigned HOST_WIDEST_INT length,
+                                 size_t size) {
+  return offset <= size && length <= size - offset;
+}
+
+/* Append to NAMES the symbols of the ELF file of SIZE bytes at DATA that
+   nm would list as anything but undefined and whose names begin with an
+   underscore.  Return false if DATA is not an ELF file we can read.  */
+
+static bool scan_elf_image(const unsigned char *data, size_t size,
+                           struct obstack *names) {
+  struct elf_image image;
+  unsigned HOST_WIDEST_INT shoff, shnum, shentsize, i;
+
+  if (size < 16 || memcmp(data, "\177ELF", 4) != 0 ||
+      (data[4] != 1 && data[4] != 2) || (data[5] != 1 && data[5] != 2))
+    return false;
+
+  image.data = data;
+  image.size = size;
+  image.is64 = data[4] == 2;
+  image.big_endian = data[5] == 2;
+
+  if (size < (image.is64 ? 64u : 52u))
+    return false;
+  shoff = elf_field(&image, image.is64 ? 40 : 32, image.is64 ? 8 : 4);
+  shentsize = elf_field(&image, image.is64 ? 58 : 46, 2);
+  shnum = elf_field(&image, image.is64 ? 60 : 48, 2);
+  if (shoff == 0)
+    return true;
+  if (shentsize < (image.is64 ? 64u : 40u) ||
+      !elf_in_bounds(shoff, shentsize, size))
+    return false;
+  /* With many sections, the count is in the first section header.  */
+  if (shnum == 0)
+    shnum = elf_field(&image, shoff + (image.is64 ? 32 : 20),
+                      image.is64 ? 8 : 4);
+  if (shnum > size / shentsize ||
+      !elf_in_bounds(shoff, shnum * shentsize, size))
+    return false;
+
+  for (i = 0; i < shnum; i++) {
+    size_t sh = shoff + i * shentsize;
+    size_t word = image.is64 ? 8 : 4;
+    unsigned HOST_WIDEST_INT symoff, symsize, symentsize, stroff, strsize;
+    unsigned HOST_WIDEST_INT link, j;
+    size_t strsh;
+
+    /* SHT_SYMTAB.  */
+    if (elf_field(&image, sh + 4, 4) != 2)
+      continue;
+
+    symoff = elf_field(&image, sh + (image.is64 ? 24 : 16), word);
+    symsize = elf_field(&image, sh + (image.is64 ? 32 : 20), word);
+    link = elf_field(&image, sh + (image.is64 ? 40 : 24), 4);
+    symentsize = elf_field(&image, sh + (image.is64 ? 56 : 36), word);
+    if (link >= shnum || symentsize < (image.is64 ? 24u : 16u) ||
+        !elf_in_bounds(symoff, symsize, size))
+      return false;
+
+    strsh = shoff + link * shentsize;
+    stroff = elf_field(&image, strsh + (image.is64 ? 24 : 16), word);
+    strsize = elf_field(&image, strsh + (image.is64 ? 32 : 20), word);
+    if (!elf_in_bounds(stroff, strsize, size))
+      return false;
+
+    for (j = symentsize; j + symentsize <= symsize; j += symentsize) {
+      size_t sym = symoff + j;
+      unsigned HOST_WIDEST_INT name = elf_field(&image, sym, 4);
+      int info = data[sym + (image.is64 ? 4 : 12)];
+      unsigned int shndx = elf_field(&image, sym + (image.is64 ? 6 : 14), 2);
+      const char *str, *str_end;
+
+      /* nm shows undefined symbols as `U', except weak ones.  */
+      if (shndx == 0 && (info >> 4) != 2)
+        continue;
+      if (name >= strsize)
+        return false;
+      str = (const char *)data + stroff + name;
+      if (*str != '_')
+        continue;
+      str_end = (const char *)memchr(str, '\0', strsize - name);
+      if (str_end == NULL)
+        return false;
+      obstack_grow0(names, str, str_end - str);
+    }
+  }
+  return true;
+}
+
+/* Like scan_elf_image, for an ar archive of ELF files.  */
+
+static bool scan_elf_archive(const unsigned char *data, size_t size,
+                             struct obstack *names) {
+  size_t offset = 8;
+
+  while (offset < size) {
+    const unsigned char *header = data + offset;
+    unsigned HOST_WIDEST_INT member_size = 0;
+    size_t name_length = 0;
+    int i;
+
+    if (size - offset < 60 || header[58] != '`' || header[59] != '\n')
+      return false;
+    for (i = 48; i < 58 && ISDIGIT(header[i]); i++)
+      member_size = member_size * 10 + (header[i] - '0');
+    offset += 60;
+    if (member_size > size - offset)
+      return false;
+
+    /* BSD archives put long member names before the contents.  */
+    if (!memcmp(header, "#1/", 3))
+      for (i = 3; i < 16 && ISDIGIT(header[i]); i++)
+        name_length = name_length * 10 + (header[i] - '0');
+    if (name_length > member_size)
+      return false;
+
+    /* Skip the symbol and name tables, "/", "/SYM64/" and "//".  */
+    if (header[0] != '/' || (header[1] != ' ' && header[1] != 'S' &&
+        header[1] != '/'))
+      if (!scan_elf_image(data + offset + name_length,
+                          member_size - name_length, names))
+        return false;
+
+    offset += member_size + (member_size & 1);
+  }
+  return true;
+}
+
+/* Scan PROG_NAME, when it is an ELF file or an archive of them, for the
+   symbols g++ uses for static constructors and destructors, as the nm
+   scan below does.  Return false if the nm scan is needed instead.  */
+
+static bool scan_elf_file(const char *prog_name, enum pass which_pass) {
+  struct obstack names;
+  struct stat st;
+  unsigned char *data;
+  char *name, *end;
+  bool mapped = false, ok;
+  int fd;
+
+  fd = open(prog_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 16 ||
+      (size_t)st.st_size != (unsigned HOST_WIDEST_INT)st.st_size) {
+    close(fd);
+    return false;
+  }
+
+#ifdef HAVE_MMAP_FILE
+  data = (unsigned char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd,
+                               0);
+  mapped = data != (unsigned char *)MAP_FAILED;
+  if (!mapped)
+#endif
+  {
+    size_t done = 0;
+    ssize_t n = 0;
+
+    data = XNEWVEC(unsigned char, st.st_size);
+    while (done < (size_t)st.st_size &&
+           (n = read(fd, data + done, st.st_size - done)) > 0)
+      done += n;
+    if (done != (size_t)st.st_size) {
+      free(data);
+      close(fd);
+      return false;
+    }
+  }
+  close(fd);
+
+  obstack_init(&names);
+  if (!memcmp(data, "!<arch>\n", 8))
+    ok = scan_elf_archive(data, st.st_size, &names);
+  else
+    ok = scan_elf_image(data, st.st_size, &names);
+
+  /* The names are only used once the whole file is known to be readable,
+     so that falling back to nm does not record anything twice.  */
+  if (ok) {
+    if (debug)
+      fprintf(stderr, "\nELF symbols with constructors/destructors.\n");
+    end = (char *)obstack_base(&names) + obstack_object_size(&names);
+    for (name = (char *)obstack_finish(&names); name < end;
+         name += strlen(name) + 1)
+      if (note_ctor_dtor(name, prog_name, which_pass) && debug)
+        fprintf(stderr, "\t%s\n", name);
+    if (debug)
+      fprintf(stderr, "\n");
+  }
+  obstack_free(&names, NULL);
+
+#ifdef HAVE_MMAP_FILE
+  if (mapped)
+    munmap((void *)data, st.st_size);
+  else
+#endif
+    free(data);
+  return ok;
+}
+
 /* Generic version to scan the name list of the loaded program for
    the symbols g++ uses for static constructors and destructors.
 
@@ -1942,6 +2226,9 @@ static void scan_prog_file(const char *prog_name, enum pass which_pass) {
   if (which_pass == PASS_SECOND)
     return;
 
+  if (scan_elf_file(prog_name, which_pass))
+    return;
+
   /* If we do not have an `nm', complain.  */
   if (nm_file_name == 0)
     fatal("cannot find 'nm'");
@@ -2014,41 +2301,8 @@ static void scan_prog_file(const char *prog_name, enum pass which_pass) {
       continue;
 
     *end = '\0';
-    switch (is_ctor_dtor(name)) {
-      case SYM_CTOR:
-        if (which_pass != PASS_LIB)
-          add_to_list(&constructors, name);
-        break;
-
-      case SYM_DTOR:
-        if (which_pass != PASS_LIB)
-          add_to_list(&destructors, name);
-        break;
-
-      case SYM_INIT:
-        if (which_pass != PASS_LIB)
-          fatal("init function found in object %s", prog_name);
-#ifndef LD_INIT_SWITCH
-        add_to_list(&constructors, name);
-#endif
-        break;
-
-      case SYM_FINI:
-        if (which_pass != PASS_LIB)
-          fatal("fini function found in object %s", prog_name);
-#ifndef LD_FINI_SWITCH
-        add_to_list(&destructors, name);
-#endif
-        break;
-
-      case SYM_DWEH:
-        if (which_pass != PASS_LIB)
-          add_to_list(&frame_tables, name);
-        break;
-
-      default: /* not a constructor or destructor */
-        continue;
-    }
+    if (!note_ctor_dtor(name, prog_name, which_pass))
+      continue;
 
     if (debug)
       fprintf(stderr, "\t%s\n", buf);
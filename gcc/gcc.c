@@ -83,6 +83,7 @@ compilation is specified by a string called a "spec".  */
 #include "gcc.h"
 #include "flags.h"
 #include "opts.h"
+#include "md5.h"
 
 /* By default there is no special suffix for target executables.  */
 /* FIXME: when autoconf is fixed, remove the host check - dj */
@@ -194,6 +195,10 @@ static int print_subprocess_help;
 
 static int report_times;
 
+/* Maximum number of input files to compile at the same time (-j).  */
+
+static int parallel_jobs = 1;
+
 /* Nonzero means place this string before uses of /, so that include
    and library files can be found in an alternate location.  */
 
@@ -2720,6 +2725,291 @@ static void add_sysrooted_prefix(struct path_prefix *pprefix,
              os_multilib);
 }
 
+/* The compilation cache.  When the environment variable COMPILE_CACHE_ENV
+   names a directory and input files are compiled to object files with
+   -c, each compiler invocation is first run with -E.  Its output is
+   hashed together with the compiler's other arguments, the checksum
+   printed by its -print-pch-checksum, the assembler options and, if
+   debug info is asked for, the working directory.  The result names an
+   entry holding the object file and the diagnostics of that
+   compilation; when the entry exists, they are copied instead of
+   running the compiler and the assembler, and otherwise they are stored
+   there once the assembler has succeeded.  */
+
+#define COMPILE_CACHE_ENV "GCC_COMPILE_CACHE"
+
+/* Directory of the cache, or null if it is not in use.  */
+static const char *compile_cache_dir;
+
+/* Name, without its suffix, of the cache entry of the compilation in
+   progress, or null if it is not cached.  */
+static char *compile_cache_entry;
+
+/* Whether that entry is already present.  */
+static bool compile_cache_hit;
+
+/* File receiving the compiler's diagnostics, to be stored in the entry.  */
+static const char *compile_cache_log;
+
+/* The checksums of the compiler executables run so far.  */
+struct compiler_checksum {
+  const char *prog;
+  char *checksum;
+  struct compiler_checksum *next;
+};
+
+static struct compiler_checksum *compiler_checksums;
+
+/* Return the checksum that compiler PROG prints for -print-pch-checksum,
+   or null if it cannot be obtained.  */
+
+static const char *get_compiler_checksum(const char *prog) {
+  struct compiler_checksum *c;
+  const char *argv[3];
+  struct pex_obj *pex;
+  char buf[256];
+  FILE *inf;
+  int err, status;
+
+  for (c = compiler_checksums; c; c = c->next)
+    if (!strcmp(c->prog, prog))
+      return c->checksum;
+
+  c = XNEW(struct compiler_checksum);
+  c->prog = xstrdup(prog);
+  c->checksum = NULL;
+  c->next = compiler_checksums;
+  compiler_checksums = c;
+
+  argv[0] = prog;
+  argv[1] = "-print-pch-checksum";
+  argv[2] = NULL;
+  pex = pex_init(PEX_USE_PIPES, programname, NULL);
+  if (pex == NULL)
+    return NULL;
+  if (pex_run(pex, PEX_SEARCH, prog, CONST_CAST(char **, argv),
+              NULL, HOST_BIT_BUCKET, &err) == NULL &&
+      (inf = pex_read_output(pex, 0)) != NULL &&
+      fgets(buf, sizeof(buf), inf) != NULL &&
+      pex_get_status(pex, 1, &status) && WIFEXITED(status) &&
+      WEXITSTATUS(status) == 0)
+    c->checksum = xstrdup(buf);
+  pex_free(pex);
+  return c->checksum;
+}
+
+/* Return true if the compiler invocation ARGV writes files other than its
+   assembler output, or does not compile at all, so that its result
+   cannot be taken from the cache.  */
+
+static bool compile_cache_unsuitable_p(const char *const *argv) {
+  static const char *const prefixes[] = {
+      "-E",     "-M",         "-fdump-",       "-fprofile-",
+      "-frepo", "-aux-info",  "--output-pch",  "-fsyntax-only",
+      "-print", "-version",   "-ftest-coverage", "-fbranch-probabilities"};
+  size_t j;
+  int i;
+
+  for (i = 1; argv[i]; i++) {
+    if (argv[i][0] != '-')
+      continue;
+    /* -d<letters> asks for dumps.  */
+    if (argv[i][1] == 'd' && strcmp(argv[i], "-dumpbase") != 0)
+      return true;
+    for (j = 0; j < ARRAY_SIZE(prefixes); j++)
+      if (!strncmp(argv[i], prefixes[j], strlen(prefixes[j])))
+        return true;
+  }
+  return false;
+}
+
+/* Compute the cache entry of the compiler invocation ARGV, and set
+   compile_cache_entry and compile_cache_hit accordingly.  If it cannot
+   be cached, for instance because preprocessing fails, leave
+   compile_cache_entry null so that the compiler reports the problem.  */
+
+static void compile_cache_lookup(const char *const *argv) {
+  struct md5_ctx ctx;
+  unsigned char digest[16];
+  char hex[2 * sizeof(digest) + 1];
+  char buf[4096];
+  const char **pp_argv;
+  const char *checksum;
+  const char *cwd;
+  struct pex_obj *pex;
+  FILE *inf;
+  size_t len;
+  int argc, i, j, err, status;
+  bool ok, debug_info = false;
+
+  if (compile_cache_unsuitable_p(argv) ||
+      (checksum = get_compiler_checksum(argv[0])) == NULL)
+    return;
+
+  md5_init_ctx(&ctx);
+  md5_process_bytes(checksum, strlen(checksum) + 1, &ctx);
+
+  /* The output file is a temporary; every other argument counts.  */
+  for (argc = 0; argv[argc]; argc++)
+    ;
+  pp_argv = XALLOCAVEC(const char *, argc + 3);
+  pp_argv[0] = argv[0];
+  pp_argv[1] = "-E";
+  pp_argv[2] = "-w";
+  for (i = 1, j = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && argv[i + 1] != NULL) {
+      i++;
+      continue;
+    }
+    md5_process_bytes(argv[i], strlen(argv[i]) + 1, &ctx);
+    pp_argv[j++] = argv[i];
+    if (!strncmp(argv[i], "-g", 2))
+      debug_info = strcmp(argv[i], "-g0") != 0;
+  }
+  pp_argv[j] = NULL;
+
+  /* The debug info names the directory of the compilation.  */
+  if (debug_info) {
+    if ((cwd = getpwd()) == NULL)
+      return;
+    md5_process_bytes(cwd, strlen(cwd) + 1, &ctx);
+  }
+
+  sprintf(buf, "%d", n_assembler_options);
+  md5_process_bytes(buf, strlen(buf) + 1, &ctx);
+  for (i = 0; i < n_assembler_options; i++)
+    md5_process_bytes(assembler_options[i], strlen(assembler_options[i]) + 1,
+                      &ctx);
+
+  /* Diagnostics come from the compilation itself, if it is run.  */
+  pex = pex_init(PEX_USE_PIPES, programname, NULL);
+  if (pex == NULL)
+    return;
+  ok = (pex_run(pex, PEX_SEARCH, pp_argv[0],
+                CONST_CAST(char **, pp_argv), NULL, HOST_BIT_BUCKET,
+                &err) == NULL &&
+        (inf = pex_read_output(pex, 0)) != NULL);
+  if (ok)
+    while ((len = fread(buf, 1, sizeof(buf), inf)) > 0)
+      md5_process_bytes(buf, len, &ctx);
+  ok = ok && pex_get_status(pex, 1, &status) && WIFEXITED(status) &&
+       WEXITSTATUS(status) == 0;
+  pex_free(pex);
+  if (!ok)
+    return;
+
+  md5_finish_ctx(&ctx, digest);
+  for (i = 0; i < (int)sizeof(digest); i++)
+    sprintf(hex + 2 * i, "%02x", digest[i]);
+  compile_cache_entry = concat(compile_cache_dir, dir_separator_str, hex, NULL);
+
+  {
+    char *object = concat(compile_cache_entry, ".o", NULL);
+    compile_cache_hit = access(object, R_OK) == 0;
+    free(object);
+  }
+  if (!compile_cache_hit) {
+    compile_cache_log = make_temp_file(".log");
+    record_temp_file(compile_cache_log, 1, 1);
+  }
+}
+
+/* Copy the file FROM to TO.  Return true if successful.  */
+
+static bool copy_file(const char *from, const char *to) {
+  char buf[4096];
+  FILE *in, *out;
+  size_t len;
+  bool ok;
+
+  in = fopen(from, "rb");
+  if (in == NULL)
+    return false;
+  out = fopen(to, "wb");
+  if (out == NULL) {
+    fclose(in);
+    return false;
+  }
+  ok = true;
+  while (ok && (len = fread(buf, 1, sizeof(buf), in)) > 0)
+    ok = fwrite(buf, 1, len, out) == len;
+  ok &= !ferror(in);
+  fclose(in);
+  ok &= fclose(out) == 0;
+  return ok;
+}
+
+/* Copy the file NAME to stderr, if it exists.  */
+
+static void print_file(const char *name) {
+  FILE *in = fopen(name, "r");
+  int c;
+
+  if (in == NULL)
+    return;
+  while ((c = getc(in)) != EOF)
+    putc(c, stderr);
+  fclose(in);
+}
+
+/* Return the argument of the -o option in ARGV, or null.  */
+
+static const char *output_file_of(const char *const *argv) {
+  const char *output = NULL;
+  int i;
+
+  for (i = 1; argv[i]; i++)
+    if (!strcmp(argv[i], "-o") && argv[i + 1] != NULL)
+      output = argv[++i];
+  return output;
+}
+
+/* Store the file FROM as the cache entry with suffix SUFFIX.  Write it
+   under a temporary name and rename it, so that concurrent compilations
+   never see a partial entry.  */
+
+static void compile_cache_store(const char *from, const char *suffix) {
+  char pid[32];
+  char *entry = concat(compile_cache_entry, suffix, NULL);
+  char *temp;
+
+  sprintf(pid, ".%ld", (long)getpid());
+  temp = concat(entry, pid, NULL);
+  if (!copy_file(from, temp) || rename(temp, entry) != 0)
+    remove(temp);
+  free(temp);
+  free(entry);
+}
+
+/* Give the assembler invocation ARGV the output stored in the cache
+   entry, and repeat the diagnostics of the compilation that produced
+   it.  Return 0 if successful, -1 if failed.  */
+
+static int compile_cache_serve(const char *const *argv) {
+  const char *output = output_file_of(argv);
+  char *object = concat(compile_cache_entry, ".o", NULL);
+  char *log = concat(compile_cache_entry, ".log", NULL);
+  int ret_code = 0;
+
+  print_file(log);
+  if (output == NULL || !copy_file(object, output)) {
+    error("cannot copy %s from the compilation cache", object);
+    ret_code = -1;
+  }
+  free(log);
+  free(object);
+  return ret_code;
+}
+
+/* Forget the cache entry of the compilation in progress.  */
+
+static void compile_cache_done(void) {
+  free(compile_cache_entry);
+  compile_cache_entry = NULL;
+  compile_cache_hit = false;
+  compile_cache_log = NULL;
+}
+
 /* Execute the command specified by the arguments on the current line of spec.
    When using pipes, this includes several piped-together commands
    with `|' between them.
@@ -2731,6 +3021,7 @@ static int execute(void) {
   int n_commands; /* # of command.  */
   char *string;
   struct pex_obj *pex;
+  bool compiler_step, assembler_step;
   struct command {
     const char *prog;  /* program name.  */
     const char **argv; /* vector of args.  */
@@ -2862,6 +3153,24 @@ static int execute(void) {
   }
 #endif
 
+  /* With the compilation cache, the compiler and the assembler that
+     follows it, in this pipeline or on the next line of the spec, are
+     skipped when the cache has their result.  */
+  compiler_step = strncmp(lbasename(commands[0].prog), "cc1", 3) == 0;
+  assembler_step = n_commands > 1 || !compiler_step;
+  if (compile_cache_dir && compile_cache_entry == NULL && compiler_step)
+    compile_cache_lookup(commands[0].argv);
+  if (compile_cache_entry && compile_cache_hit) {
+    int ret_code = 0;
+
+    execution_count++;
+    if (assembler_step) {
+      ret_code = compile_cache_serve(commands[n_commands - 1].argv);
+      compile_cache_done();
+    }
+    return ret_code;
+  }
+
   /* Run each piped subprocess.  */
 
   pex = pex_init(PEX_USE_PIPES | (report_times ? PEX_RECORD_TIMES : 0),
@@ -2877,7 +3186,8 @@ static int execute(void) {
     errmsg = pex_run(pex,
                      ((i + 1 == n_commands ? PEX_LAST : 0) |
                       (string == commands[i].prog ? PEX_SEARCH : 0)),
-                     string, CONST_CAST(char **, commands[i].argv), NULL, NULL,
+                     string, CONST_CAST(char **, commands[i].argv), NULL,
+                     (i == 0 && compiler_step ? compile_cache_log : NULL),
                      &err);
     if (errmsg != NULL) {
       if (err == 0)
@@ -2913,6 +3223,10 @@ static int execute(void) {
 
     pex_free(pex);
 
+    /* Show the diagnostics that were kept for the cache.  */
+    if (compile_cache_log && compiler_step)
+      print_file(compile_cache_log);
+
     for (i = 0; i < n_commands; ++i) {
       int status = statuses[i];
 
@@ -2955,6 +3269,16 @@ See %s for instructions.",
       }
     }
 
+    if (compile_cache_entry && (ret_code != 0 || assembler_step)) {
+      const char *output = output_file_of(commands[n_commands - 1].argv);
+
+      if (ret_code == 0 && output != NULL) {
+        compile_cache_store(compile_cache_log, ".log");
+        compile_cache_store(output, ".o");
+      }
+      compile_cache_done();
+    }
+
     return ret_code;
   }
 }
@@ -3161,6 +3485,9 @@ static void display_help(void) {
         stdout);
   fputs(_("  -time                    Time the execution of each subprocess\n"),
         stdout);
+  fputs(_("  -j <number>              Compile up to <number> input files at "
+          "once\n"),
+        stdout);
   fputs(_("  -specs=<file>            Override built-in specs with the "
           "contents of <file>\n"),
         stdout);
@@ -3660,7 +3987,18 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
       user_specs_tail = user;
     } else if (strcmp(argv[i], "-time") == 0)
       report_times = 1;
-    else if (strcmp(argv[i], "-pipe") == 0) {
+    else if (strncmp(argv[i], "-j", 2) == 0) {
+      const char *jobs = argv[i] + 2;
+
+      if (*jobs == 0) {
+        if (++i >= argc)
+          fatal("argument to '-j' is missing");
+        jobs = argv[i];
+      }
+      if (*jobs == 0 || strspn(jobs, "0123456789") != strlen(jobs) ||
+          (parallel_jobs = atoi(jobs)) < 1)
+        fatal("argument to '-j' should be a positive number");
+    } else if (strcmp(argv[i], "-pipe") == 0) {
       /* -pipe has to go into the switches array as well as
          setting a flag.  */
       use_pipes = 1;
@@ -4007,6 +4345,10 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
       ;
     else if (strcmp(argv[i], "-time") == 0)
       ;
+    else if (strcmp(argv[i], "-j") == 0)
+      i++;
+    else if (strncmp(argv[i], "-j", 2) == 0)
+      ;
     else if (strcmp(argv[i], "-###") == 0)
       ;
     else if (argv[i][0] == '-' && argv[i][1] != 0) {
@@ -5805,6 +6147,141 @@ static void fatal_error(int signum) {
   kill(getpid(), signum);
 }
 
+#ifdef HAVE_FORK
+/* Under -j, each input file is compiled by a forked copy of the driver
+   that runs the compiler's spec for it.  Its diagnostics go to a
+   temporary file, which the parent copies to stderr once every earlier
+   input has been reported, so the output reads as if the inputs had
+   been compiled one after another.  The child deletes its own
+   temporary files; its exit status reports failure to the parent.  */
+
+struct parallel_compile {
+  pid_t pid;
+  FILE *log;
+  int status;
+  bool done;
+};
+
+/* One entry for each input file, or null if not compiling in parallel.  */
+static struct parallel_compile *parallel_compiles;
+
+/* Number of children that have not been waited for.  */
+static int parallel_running;
+
+/* Inputs below this have been dealt with by the parent; the first one
+   whose diagnostics have not been copied yet.  */
+static int parallel_reached;
+static int parallel_reported;
+
+/* Exit status of a child whose compiler died of a signal.  */
+#define PARALLEL_SIGNAL_STATUS 255
+
+/* Copy the diagnostics of finished children to stderr, in input order,
+   and account for their failures.  */
+
+static void report_parallel_compiles(void) {
+  while (parallel_reported < parallel_reached) {
+    struct parallel_compile *pc = &parallel_compiles[parallel_reported];
+    int status, c;
+
+    if (pc->pid != 0 && !pc->done)
+      break;
+    parallel_reported++;
+    if (pc->pid == 0)
+      continue;
+
+    rewind(pc->log);
+    while ((c = getc(pc->log)) != EOF)
+      putc(c, stderr);
+    fclose(pc->log);
+
+    status = pc->status;
+    if (WIFSIGNALED(status) ||
+        WEXITSTATUS(status) == PARALLEL_SIGNAL_STATUS) {
+      signal_count++;
+      error_count++;
+    } else if (WEXITSTATUS(status) != 0) {
+      if (WEXITSTATUS(status) > greatest_status)
+        greatest_status = WEXITSTATUS(status);
+      error_count++;
+    }
+  }
+}
+
+/* Wait for one child to finish.  */
+
+static void wait_parallel_compile(void) {
+  int status, i;
+  pid_t pid = waitpid(-1, &status, 0);
+
+  if (pid < 0)
+    pfatal_with_name("waitpid");
+  for (i = 0; i < parallel_reached; i++)
+    if (parallel_compiles[i].pid == pid && !parallel_compiles[i].done) {
+      parallel_compiles[i].status = status;
+      parallel_compiles[i].done = true;
+      parallel_running--;
+      break;
+    }
+  report_parallel_compiles();
+}
+
+/* Wait for all children and report them.  */
+
+static void finish_parallel_compiles(void) {
+  while (parallel_running > 0)
+    wait_parallel_compile();
+  report_parallel_compiles();
+}
+
+/* Compile input file N in a child, once fewer than -j children are
+   running.  Return 0 if the child was started, and otherwise the result
+   of compiling N in this process.  */
+
+static int start_parallel_compile(int n) {
+  struct parallel_compile *pc = &parallel_compiles[n];
+  int value;
+
+  while (parallel_running >= parallel_jobs)
+    wait_parallel_compile();
+
+  pc->log = tmpfile();
+  if (pc->log != NULL) {
+    fflush(stdout);
+    fflush(stderr);
+    pc->pid = fork();
+  }
+  if (pc->log == NULL || pc->pid < 0) {
+    if (pc->log != NULL)
+      fclose(pc->log);
+    pc->pid = 0;
+    finish_parallel_compiles();
+    return do_spec(input_file_compiler->spec);
+  }
+
+  if (pc->pid == 0) {
+    /* The temporary files recorded so far are the parent's.  */
+    always_delete_queue = 0;
+    failure_delete_queue = 0;
+    dup2(fileno(pc->log), STDERR_FILENO);
+
+    value = do_spec(input_file_compiler->spec);
+    if (value < 0)
+      delete_failure_queue();
+    delete_temp_files();
+    fflush(stdout);
+    fflush(stderr);
+    exit(value >= 0        ? 0
+         : signal_count    ? PARALLEL_SIGNAL_STATUS
+                           : MIN(greatest_status, PARALLEL_SIGNAL_STATUS - 1));
+  }
+
+  parallel_running++;
+  parallel_reached = n + 1;
+  return 0;
+}
+#endif
+
 extern int main(int, char **);
 
 int main(int argc, char **argv) {
@@ -6255,6 +6732,25 @@ int main(int argc, char **argv) {
   if (!combine_inputs && have_c && have_o && lang_n_infiles > 1)
     fatal("cannot specify -o with -c or -S with multiple files");
 
+  /* Only object files are cached, and only when the commands that make
+     them are run as the spec says.  */
+  p = getenv(COMPILE_CACHE_ENV);
+  if (p && *p && have_c && !combine_inputs && !save_temps_flag &&
+      !verbose_flag && !wrapper_string && !print_subprocess_help) {
+    compile_cache_dir = p;
+    for (i = 0; (int)i < n_switches; i++)
+      if (!strcmp(switches[i].part1, "S"))
+        compile_cache_dir = NULL;
+  }
+
+#ifdef HAVE_FORK
+  /* The outputs of the children are not known to this process, so only
+     compile in parallel when nothing is linked.  */
+  if (parallel_jobs > 1 && have_c && !combine_inputs && lang_n_infiles > 1 &&
+      !print_subprocess_help)
+    parallel_compiles = XCNEWVEC(struct parallel_compile, n_infiles);
+#endif
+
   if (combine_flag && save_temps_flag) {
     bool save_combine_inputs = combine_inputs;
     /* Must do a separate pre-processing pass for C & Objective-C files, to
@@ -6327,11 +6823,20 @@ int main(int argc, char **argv) {
       /* Ok, we found an applicable compiler.  Run its spec.  */
 
       if (input_file_compiler->spec[0] == '#') {
+#ifdef HAVE_FORK
+        if (parallel_compiles)
+          finish_parallel_compiles();
+#endif
         error("%s: %s compiler not installed on this system", input_filename,
               &input_file_compiler->spec[1]);
         this_file_error = 1;
       } else {
-        value = do_spec(input_file_compiler->spec);
+#ifdef HAVE_FORK
+        if (parallel_compiles)
+          value = start_parallel_compile(i);
+        else
+#endif
+          value = do_spec(input_file_compiler->spec);
         infiles[i].compiled = true;
         if (value < 0)
           this_file_error = 1;
@@ -6353,8 +6858,14 @@ int main(int argc, char **argv) {
     }
     /* If this compilation succeeded, don't delete those files later.  */
     clear_failure_queue();
+    compile_cache_done();
   }
 
+#ifdef HAVE_FORK
+  if (parallel_compiles)
+    finish_parallel_compiles();
+#endif
+
   /* Reset the input file name to the first compile/object file name, for use
      with %b in LINK_SPEC. We use the first input file that we can find
      a compiler to compile it instead of using infiles.language since for
@@ -1683,6 +1683,7 @@ struct walk_type_data {
   const char *reorder_fn;
   bool needs_cast_p;
   bool fn_wants_lvalue;
+  bool in_nested_ptr;
 };
 
 /* Print a mangled name representing T to OF.  */
@@ -1900,7 +1901,9 @@ static void walk_type(type_p t, struct walk_type_data *d) {
           output_escaped_param(d, nested_ptr_d->convert_from, "nested_ptr");
           oprintf(d->of, ";\n");
 
+          d->in_nested_ptr = true;
           d->process_field(nested_ptr_d->type, d);
+          d->in_nested_ptr = false;
 
           if (d->fn_wants_lvalue) {
             oprintf(d->of, "%*s%s = ", d->indent, "", d->prev_val[2]);
@@ -2474,7 +2477,12 @@ static void write_types_local_process_field(type_p f,
     case TYPE_STRING:
       oprintf(d->of, "%*sif ((void *)(%s) == this_obj)\n", d->indent, "",
               d->prev_val[3]);
-      oprintf(d->of, "%*s  op (&(%s), cookie);\n", d->indent, "", d->val);
+      oprintf(d->of, "%*s  op (&(%s), ", d->indent, "", d->val);
+      if (d->in_nested_ptr)
+        oprintf(d->of, "&(%s), ", d->prev_val[2]);
+      else
+        oprintf(d->of, "NULL, ");
+      oprintf(d->of, "cookie);\n");
       break;
 
     case TYPE_SCALAR:
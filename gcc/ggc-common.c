@@ -43,6 +43,10 @@ along with GCC; see the file COPYING3.  If not see
 #endif
 #endif
 
+#ifdef GGC_PARALLEL_MARK
+#include <pthread.h>
+#endif
+
 #ifndef MAP_FAILED
 #define MAP_FAILED ((void *)-1)
 #endif
@@ -57,6 +61,7 @@ bool ggc_protect_identifiers = true;
 static ggc_statistics *ggc_stats;
 
 struct traversal_state;
+struct pch_reloc;
 
 static int ggc_htab_delete(void **, void *);
 static hashval_t saving_htab_hash(const void *);
@@ -64,9 +69,14 @@ static int saving_htab_eq(const void *, const void *);
 static int call_count(void **, void *);
 static int call_alloc(void **, void *);
 static int compare_ptr_data(const void *, const void *);
-static void relocate_ptrs(void *, void *);
+static void relocate_ptrs(void *, void *, void *);
 static void write_pch_globals(const struct ggc_root_tab *const *tab,
                               struct traversal_state *state);
+static void relocate_pch_globals(const struct ggc_root_tab *const *tab,
+                                 const struct pch_reloc *r, size_t n);
+static void relocate_pch_image(char *addr, const unsigned char *relocs,
+                               size_t nwords, const struct pch_reloc *r,
+                               size_t n);
 static double ggc_rlimit_bound(double);
 
 /* Maintain global roots that are preserved during GC.  */
@@ -84,6 +94,110 @@ static int ggc_htab_delete(void **slot, void *info) {
   return 1;
 }
 
+int ggc_mark_threads = 1;
+
+#ifdef GGC_PARALLEL_MARK
+/* Marking recurses through the objects, so give the threads as much
+   stack as the main thread usually has.  */
+#define MARK_THREAD_STACK_SIZE (64 * 1024 * 1024)
+
+/* The roots of gt_ggc_rtab, numbered across its tables, which the
+   marking threads claim MARK_ROOT_BATCH at a time.  Claiming elements
+   rather than whole tables spreads the large arrays of roots, such as
+   global_trees, over the threads.  Each root is still marked by a
+   single thread, so a root from which most of the heap is reached
+   keeps that thread busy while the others finish.  */
+#define MARK_ROOT_BATCH 16
+
+static const struct ggc_root_tab **mark_root_tabs;
+static size_t n_mark_root_tabs;
+
+/* The number of the first root of each table, and past the last one
+   the number of roots.  */
+static size_t *mark_root_starts;
+
+static size_t next_mark_root;
+
+/* Mark the roots that no other thread has claimed.  */
+
+static void *mark_claimed_roots(void *data ATTRIBUTE_UNUSED) {
+  size_t n_roots = mark_root_starts[n_mark_root_tabs];
+  size_t first, last, i, lo, hi, t, elt;
+
+  while ((first = __sync_fetch_and_add(&next_mark_root, MARK_ROOT_BATCH)) <
+         n_roots) {
+    last = MIN(first + MARK_ROOT_BATCH, n_roots);
+
+    /* Find the last table that starts at or before FIRST.  */
+    lo = 0;
+    hi = n_mark_root_tabs;
+    while (hi - lo > 1) {
+      t = (lo + hi) / 2;
+      if (mark_root_starts[t] <= first)
+        lo = t;
+      else
+        hi = t;
+    }
+
+    for (i = first, t = lo; i < last; i++) {
+      const struct ggc_root_tab *rti;
+
+      while (mark_root_starts[t + 1] <= i)
+        t++;
+      rti = mark_root_tabs[t];
+      elt = i - mark_root_starts[t];
+      (*rti->cb)(*(void **)((char *)rti->base + rti->stride * elt));
+    }
+  }
+  return NULL;
+}
+
+/* Mark the roots of gt_ggc_rtab with ggc_mark_threads threads,
+   including this one.  */
+
+static void mark_roots_in_parallel(void) {
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  pthread_t *threads;
+  pthread_attr_t attr;
+  int i, n_threads;
+
+  if (mark_root_tabs == NULL) {
+    for (rt = gt_ggc_rtab; *rt; rt++)
+      for (rti = *rt; rti->base != NULL; rti++)
+        n_mark_root_tabs++;
+    mark_root_tabs = XNEWVEC(const struct ggc_root_tab *, n_mark_root_tabs);
+    mark_root_starts = XNEWVEC(size_t, n_mark_root_tabs + 1);
+    n_mark_root_tabs = 0;
+    mark_root_starts[0] = 0;
+    for (rt = gt_ggc_rtab; *rt; rt++)
+      for (rti = *rt; rti->base != NULL; rti++) {
+        mark_root_tabs[n_mark_root_tabs] = rti;
+        mark_root_starts[n_mark_root_tabs + 1] =
+            mark_root_starts[n_mark_root_tabs] + rti->nelt;
+        n_mark_root_tabs++;
+      }
+  }
+  next_mark_root = 0;
+
+  /* If a thread cannot be started, the others do its share.  */
+  threads = XALLOCAVEC(pthread_t, ggc_mark_threads);
+  n_threads = 0;
+  if (pthread_attr_init(&attr) == 0) {
+    pthread_attr_setstacksize(&attr, MARK_THREAD_STACK_SIZE);
+    for (i = 1; i < ggc_mark_threads; i++)
+      if (pthread_create(&threads[n_threads], &attr, mark_claimed_roots,
+                         NULL) == 0)
+        n_threads++;
+    pthread_attr_destroy(&attr);
+  }
+
+  mark_claimed_roots(NULL);
+  for (i = 0; i < n_threads; i++)
+    pthread_join(threads[i], NULL);
+}
+#endif
+
 /* Iterate through all registered roots and mark each element.  */
 
 void ggc_mark_roots(void) {
@@ -97,10 +211,17 @@ void ggc_mark_roots(void) {
     for (rti = *rt; rti->base != NULL; rti++)
       memset(rti->base, 0, rti->stride);
 
-  for (rt = gt_ggc_rtab; *rt; rt++)
-    for (rti = *rt; rti->base != NULL; rti++)
-      for (i = 0; i < rti->nelt; i++)
-        (*rti->cb)(*(void **)((char *)rti->base + rti->stride * i));
+  /* Only these roots are marked in parallel; the cache tables below
+     must see every other mark.  */
+#ifdef GGC_PARALLEL_MARK
+  if (ggc_mark_threads > 1)
+    mark_roots_in_parallel();
+  else
+#endif
+    for (rt = gt_ggc_rtab; *rt; rt++)
+      for (rti = *rt; rti->base != NULL; rti++)
+        for (i = 0; i < rti->nelt; i++)
+          (*rti->cb)(*(void **)((char *)rti->base + rti->stride * i));
 
   if (ggc_protect_identifiers)
     ggc_mark_stringpool();
@@ -287,14 +408,56 @@ struct traversal_state {
   size_t count;
   struct ptr_data **ptrs;
   size_t ptrs_i;
+
+  /* While writing objects, the object being written, the address the
+     PCH image is laid out at, and a bitmap with one bit per
+     pointer-sized word of the image that holds a pointer into it.  */
+  struct ptr_data *ptr;
+  char *base;
+  unsigned char *relocs;
+
+  /* True if the objects of the PCH images already read stay where they
+     are rather than being copied into this one.  */
+  bool chain;
 };
 
+/* A PCH image that has been read in, in the order they were read.  A
+   PCH file written later may be a layer over all of them.  */
+
+struct pch_image {
+  char *addr;
+  size_t size;
+
+  /* The contents of the image as read in, or NULL if a layer will not
+     be written over it.  */
+  char *snapshot;
+};
+
+static struct pch_image *pch_images;
+static size_t n_pch_images;
+
+/* Return the PCH image that P points into, or NULL.  */
+
+static struct pch_image *find_pch_image(const void *p) {
+  size_t i;
+
+  for (i = 0; i < n_pch_images; i++)
+    if ((const char *)p >= pch_images[i].addr &&
+        (const char *)p < pch_images[i].addr + pch_images[i].size)
+      return &pch_images[i];
+  return NULL;
+}
+
 /* Callbacks for htab_traverse.  */
 
 static int call_count(void **slot, void *state_p) {
   struct ptr_data *d = (struct ptr_data *)*slot;
   struct traversal_state *state = (struct traversal_state *)state_p;
 
+  /* Objects of an image below a layer keep their address.  */
+  if (state->chain && find_pch_image(d->obj))
+    return 1;
+
   ggc_pch_count_object(state->d, d->obj, d->size, d->note_ptr_fn == gt_pch_p_S,
                        d->type);
   state->count++;
@@ -305,6 +468,11 @@ static int call_alloc(void **slot, void *state_p) {
   struct ptr_data *d = (struct ptr_data *)*slot;
   struct traversal_state *state = (struct traversal_state *)state_p;
 
+  if (state->chain && find_pch_image(d->obj)) {
+    d->new_addr = d->obj;
+    return 1;
+  }
+
   d->new_addr = ggc_pch_alloc_object(state->d, d->obj, d->size,
                                      d->note_ptr_fn == gt_pch_p_S, d->type);
   state->ptrs[state->ptrs_i++] = d;
@@ -322,11 +490,11 @@ static int compare_ptr_data(const void *p1_p, const void *p2_p) {
 
 /* Callbacks for note_ptr_fn.  */
 
-static void relocate_ptrs(void *ptr_p, void *state_p) {
+static void relocate_ptrs(void *ptr_p, void *real_ptr_p, void *state_p) {
   void **ptr = (void **)ptr_p;
-  struct traversal_state *state ATTRIBUTE_UNUSED =
-      (struct traversal_state *)state_p;
+  struct traversal_state *state = (struct traversal_state *)state_p;
   struct ptr_data *result;
+  char *slot;
 
   if (*ptr == NULL || *ptr == (void *)1)
     return;
@@ -335,6 +503,23 @@ static void relocate_ptrs(void *ptr_p, void *state_p) {
                                                   POINTER_HASH(*ptr));
   gcc_assert(result);
   *ptr = result->new_addr;
+
+  /* Remember where the pointer will live in the image, so that the
+     image can be relocated if it cannot be mapped at its base.  A
+     nested pointer is converted in a temporary and stored back into
+     REAL_PTR_P, and a reorder callback may ask for the new value of a
+     pointer it keeps elsewhere; only slots in the object count.  */
+  if (state->relocs == NULL)
+    return;
+  slot = (char *)(real_ptr_p ? real_ptr_p : ptr_p);
+  if (slot >= (char *)state->ptr->obj &&
+      slot < (char *)state->ptr->obj + state->ptr->size &&
+      (slot - (char *)state->ptr->obj) % sizeof(void *) == 0) {
+    size_t word = ((char *)state->ptr->new_addr - state->base +
+                   (slot - (char *)state->ptr->obj)) /
+                  sizeof(void *);
+    state->relocs[word / CHAR_BIT] |= 1 << (word % CHAR_BIT);
+  }
 }
 
 /* Write out, after relocation, the pointers in TAB.  */
@@ -361,6 +546,121 @@ static void write_pch_globals(const struct ggc_root_tab *const *tab,
       }
 }
 
+/* How to relocate the pointers into one PCH image: those between
+   OLD_BASE and OLD_BASE + SIZE move by DELTA.  */
+
+struct pch_reloc {
+  char *old_base;
+  size_t size;
+  ptrdiff_t delta;
+};
+
+/* Return P relocated according to the N entries of R.  */
+
+static inline char *relocate_pch_pointer(char *p, const struct pch_reloc *r,
+                                         size_t n) {
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if (p >= r[i].old_base && p < r[i].old_base + r[i].size)
+      return p + r[i].delta;
+  return p;
+}
+
+/* Relocate, according to the N entries of R, each of the global
+   pointers in TAB.  */
+static void relocate_pch_globals(const struct ggc_root_tab *const *tab,
+                                 const struct pch_reloc *r, size_t n) {
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  size_t i;
+
+  for (rt = tab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      for (i = 0; i < rti->nelt; i++) {
+        char **ptr = (char **)((char *)rti->base + rti->stride * i);
+        *ptr = relocate_pch_pointer(*ptr, r, n);
+      }
+}
+
+/* Relocate, according to the N entries of R, each pointer in the NWORDS
+   pointer-sized words at ADDR whose bit is set in RELOCS.  Only pages
+   that hold pointers are touched.  */
+static void relocate_pch_image(char *addr, const unsigned char *relocs,
+                               size_t nwords, const struct pch_reloc *r,
+                               size_t n) {
+  size_t i, j;
+
+  for (i = 0; i < (nwords + CHAR_BIT - 1) / CHAR_BIT; i++)
+    if (relocs[i])
+      for (j = 0; j < CHAR_BIT; j++)
+        if (relocs[i] & (1 << j)) {
+          char **ptr = (char **)(addr + (i * CHAR_BIT + j) * sizeof(void *));
+          *ptr = relocate_pch_pointer(*ptr, r, n);
+        }
+}
+
+/* Where an image below a layer was when the layer was written.  */
+
+struct pch_range {
+  void *addr;
+  size_t size;
+};
+
+/* The header of a change a layer makes to an object of an image below
+   it.  It is followed by the SIZE bytes of the object and by a bitmap
+   of the words that hold pointers.  A NULL ADDR ends the list.  */
+
+struct pch_patch {
+  void *addr;
+  size_t size;
+};
+
+/* Callback for htab_traverse.  Write out the object of an image below a
+   layer if it has changed since the image was read.  */
+
+static int write_pch_patch(void **slot, void *state_p) {
+  struct ptr_data *d = (struct ptr_data *)*slot;
+  struct traversal_state *state = (struct traversal_state *)state_p;
+  struct pch_image *image;
+  struct pch_patch patch;
+  size_t relocs_size;
+  char *copy;
+
+  if (d->note_ptr_fn == gt_pch_p_S)
+    return 1;
+  image = find_pch_image(d->obj);
+  if (image == NULL)
+    return 1;
+  gcc_assert(image->snapshot);
+  if (memcmp(d->obj, image->snapshot + ((char *)d->obj - image->addr),
+             d->size) == 0)
+    return 1;
+
+  copy = XNEWVAR(char, d->size);
+  memcpy(copy, d->obj, d->size);
+  relocs_size = (d->size / sizeof(void *) + CHAR_BIT - 1) / CHAR_BIT;
+  state->ptr = d;
+  state->base = (char *)d->obj;
+  state->relocs = XCNEWVEC(unsigned char, relocs_size);
+  if (d->reorder_fn != NULL)
+    d->reorder_fn(d->obj, d->note_ptr_cookie, relocate_ptrs, state);
+  d->note_ptr_fn(d->obj, d->note_ptr_cookie, relocate_ptrs, state);
+
+  patch.addr = d->obj;
+  patch.size = d->size;
+  if (fwrite(&patch, sizeof(patch), 1, state->f) != 1 ||
+      fwrite(d->obj, d->size, 1, state->f) != 1 ||
+      fwrite(state->relocs, relocs_size, 1, state->f) != 1)
+    fatal_error("can't write PCH file: %m");
+
+  memcpy(d->obj, copy, d->size);
+  free(copy);
+  free(state->relocs);
+  state->relocs = NULL;
+  return 1;
+}
+
 /* Hold the information we need to mmap the file back in.  */
 
 struct mmap_info {
@@ -371,7 +671,7 @@ struct mmap_info {
 
 /* Write out the state of the compiler to F.  */
 
-void gt_pch_save(FILE *f) {
+void gt_pch_save(FILE *f, bool chain) {
   const struct ggc_root_tab *const *rt;
   const struct ggc_root_tab *rti;
   size_t i;
@@ -379,6 +679,10 @@ void gt_pch_save(FILE *f) {
   char *this_object = NULL;
   size_t this_object_size = 0;
   struct mmap_info mmi;
+  size_t relocs_size;
+  unsigned char *relocs;
+  size_t nbases;
+  struct pch_patch end;
   const size_t mmap_offset_alignment = host_hooks.gt_pch_alloc_granularity();
 
   gt_pch_save_stringpool();
@@ -399,6 +703,7 @@ void gt_pch_save(FILE *f) {
   state.f = f;
   state.d = init_ggc_pch();
   state.count = 0;
+  state.chain = chain;
   htab_traverse(saving_htab, call_count, &state);
 
   mmi.size = ggc_pch_total_size(state.d);
@@ -410,7 +715,15 @@ void gt_pch_save(FILE *f) {
      HOST_HOOKS_GT_PCH_USE_ADDRESS.)  */
   mmi.preferred_base = host_hooks.gt_pch_get_address(mmi.size, fileno(f));
 
+  /* If no address was found, lay the image out at a nominal one; it
+     will be relocated when read.  */
+  if (mmi.preferred_base == NULL)
+    mmi.preferred_base = (void *)mmap_offset_alignment;
+
   ggc_pch_this_base(state.d, mmi.preferred_base);
+  state.base = (char *)mmi.preferred_base;
+  relocs_size = (mmi.size / sizeof(void *) + CHAR_BIT - 1) / CHAR_BIT;
+  relocs = state.relocs = XCNEWVEC(unsigned char, relocs_size);
 
   state.ptrs = XNEWVEC(struct ptr_data *, state.count);
   state.ptrs_i = 0;
@@ -448,6 +761,7 @@ void gt_pch_save(FILE *f) {
 
   /* Actually write out the objects.  */
   for (i = 0; i < state.count; i++) {
+    state.ptr = state.ptrs[i];
     if (this_object_size < state.ptrs[i]->size) {
       this_object_size = state.ptrs[i]->size;
       this_object = XRESIZEVAR(char, this_object, this_object_size);
@@ -467,20 +781,54 @@ void gt_pch_save(FILE *f) {
       memcpy(state.ptrs[i]->obj, this_object, state.ptrs[i]->size);
   }
   ggc_pch_finish(state.d, state.f);
+
+  /* Write out the relocation bitmap.  */
+  if (fwrite(relocs, relocs_size, 1, state.f) != 1)
+    fatal_error("can't write PCH file: %m");
+
+  /* Write out where the images below a layer are, and the objects of
+     theirs that have changed since they were read.  */
+  nbases = chain ? n_pch_images : 0;
+  if (fwrite(&nbases, sizeof(nbases), 1, state.f) != 1)
+    fatal_error("can't write PCH file: %m");
+  for (i = 0; i < nbases; i++) {
+    struct pch_range range;
+
+    range.addr = pch_images[i].addr;
+    range.size = pch_images[i].size;
+    if (fwrite(&range, sizeof(range), 1, state.f) != 1)
+      fatal_error("can't write PCH file: %m");
+  }
+  if (chain)
+    htab_traverse(saving_htab, write_pch_patch, &state);
+  end.addr = NULL;
+  end.size = 0;
+  if (fwrite(&end, sizeof(end), 1, state.f) != 1)
+    fatal_error("can't write PCH file: %m");
+
   gt_pch_fixup_stringpool();
 
+  free(this_object);
+  free(relocs);
   free(state.ptrs);
   htab_delete(saving_htab);
 }
 
 /* Read the state of the compiler back in from F.  */
 
-void gt_pch_restore(FILE *f) {
+void gt_pch_restore(FILE *f, bool keep) {
   const struct ggc_root_tab *const *rt;
   const struct ggc_root_tab *rti;
   size_t i;
   struct mmap_info mmi;
   int result;
+  char *addr;
+  size_t relocs_size;
+  unsigned char *relocs;
+  size_t nbases;
+  struct pch_reloc *r;
+  bool relocate;
+  struct pch_image *image;
 
   /* Delete any deletable objects.  This makes ggc_pch_read much
      faster, as it can be sure that no GCable objects remain other
@@ -513,18 +861,121 @@ void gt_pch_restore(FILE *f) {
   if (fread(&mmi, sizeof(mmi), 1, f) != 1)
     fatal_error("can't read PCH file: %m");
 
-  result = host_hooks.gt_pch_use_address(mmi.preferred_base, mmi.size,
-                                         fileno(f), mmi.offset);
-  if (result < 0)
-    fatal_error("had to relocate PCH");
+  addr = (char *)mmi.preferred_base;
+  if (PARAM_VALUE(PCH_RELOCATE))
+    result = -1;
+  else
+    result = host_hooks.gt_pch_use_address(addr, mmi.size, fileno(f),
+                                           mmi.offset);
+
+  /* If the image cannot go at its preferred base, put it anywhere and
+     relocate it.  */
+  if (result < 0) {
+    addr = NULL;
+#if HAVE_MMAP_FILE
+    addr = (char *)mmap(NULL, mmi.size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                        fileno(f), mmi.offset);
+    if (addr == (char *)MAP_FAILED)
+      addr = NULL;
+    else
+      result = 1;
+#endif
+    if (addr == NULL) {
+      size_t align = host_hooks.gt_pch_alloc_granularity();
+      addr = XNEWVEC(char, mmi.size + align);
+      addr += align - (size_t)addr % align;
+      result = 0;
+    }
+  }
+
   if (result == 0) {
     if (fseek(f, mmi.offset, SEEK_SET) != 0 ||
-        fread(mmi.preferred_base, mmi.size, 1, f) != 1)
+        fread(addr, mmi.size, 1, f) != 1)
       fatal_error("can't read PCH file: %m");
   } else if (fseek(f, mmi.offset + mmi.size, SEEK_SET) != 0)
     fatal_error("can't read PCH file: %m");
 
-  ggc_pch_read(f, mmi.preferred_base);
+  ggc_pch_read(f, addr);
+
+  relocs_size = (mmi.size / sizeof(void *) + CHAR_BIT - 1) / CHAR_BIT;
+  relocs = XNEWVEC(unsigned char, relocs_size);
+  if (fread(relocs, relocs_size, 1, f) != 1 ||
+      fread(&nbases, sizeof(nbases), 1, f) != 1)
+    fatal_error("can't read PCH file: %m");
+
+  /* A layer must be read over the very images it was written over.  */
+  if (nbases != n_pch_images)
+    fatal_error("PCH file was not written over the precompiled headers "
+                "read so far");
+
+  /* The image itself, and each image below it, may have moved since
+     the file was written.  */
+  r = XNEWVEC(struct pch_reloc, nbases + 1);
+  r[0].old_base = (char *)mmi.preferred_base;
+  r[0].size = mmi.size;
+  r[0].delta = addr - (char *)mmi.preferred_base;
+  relocate = r[0].delta != 0;
+  for (i = 0; i < nbases; i++) {
+    struct pch_range range;
+
+    if (fread(&range, sizeof(range), 1, f) != 1)
+      fatal_error("can't read PCH file: %m");
+    if (range.size != pch_images[i].size)
+      fatal_error("PCH file was not written over the precompiled headers "
+                  "read so far");
+    r[i + 1].old_base = (char *)range.addr;
+    r[i + 1].size = range.size;
+    r[i + 1].delta = pch_images[i].addr - (char *)range.addr;
+    relocate |= r[i + 1].delta != 0;
+  }
+
+  if (relocate) {
+    relocate_pch_image(addr, relocs, mmi.size / sizeof(void *), r, nbases + 1);
+    relocate_pch_globals(gt_ggc_rtab, r, nbases + 1);
+    relocate_pch_globals(gt_pch_cache_rtab, r, nbases + 1);
+  }
+  free(relocs);
+
+  /* Apply the changes a layer made to the objects of the images below.  */
+  for (;;) {
+    struct pch_patch patch;
+    char *target;
+
+    if (fread(&patch, sizeof(patch), 1, f) != 1)
+      fatal_error("can't read PCH file: %m");
+    if (patch.addr == NULL)
+      break;
+
+    target = relocate_pch_pointer((char *)patch.addr, r + 1, nbases);
+    image = find_pch_image(target);
+    if (image == NULL || target + patch.size > image->addr + image->size)
+      fatal_error("PCH file is corrupt");
+
+    relocs_size = (patch.size / sizeof(void *) + CHAR_BIT - 1) / CHAR_BIT;
+    relocs = XNEWVEC(unsigned char, relocs_size);
+    if (fread(target, patch.size, 1, f) != 1 ||
+        fread(relocs, relocs_size, 1, f) != 1)
+      fatal_error("can't read PCH file: %m");
+    if (relocate)
+      relocate_pch_image(target, relocs, patch.size / sizeof(void *), r,
+                         nbases + 1);
+    free(relocs);
+
+    if (image->snapshot)
+      memcpy(image->snapshot + (target - image->addr), target, patch.size);
+  }
+  free(r);
+
+  /* Remember the image, so that a layer can be written over it.  */
+  pch_images = XRESIZEVEC(struct pch_image, pch_images, n_pch_images + 1);
+  image = &pch_images[n_pch_images++];
+  image->addr = addr;
+  image->size = mmi.size;
+  image->snapshot = NULL;
+  if (keep) {
+    image->snapshot = XNEWVEC(char, mmi.size);
+    memcpy(image->snapshot, addr, mmi.size);
+  }
 
   gt_pch_restore_stringpool();
 }
@@ -541,13 +992,16 @@ void *default_gt_pch_get_address(size_t size ATTRIBUTE_UNUSED,
 /* Default version of HOST_HOOKS_GT_PCH_USE_ADDRESS when mmap is not present.
    Allocate SIZE bytes with malloc.  Return 0 if the address we got is the
    same as base, indicating that the memory has been allocated but needs to
-   be read in from the file.  Return -1 if the address differs, to relocation
-   of the PCH file would be required.  */
+   be read in from the file.  Return -1 if the address differs, so that
+   the PCH file will be read elsewhere and relocated.  */
 
 int default_gt_pch_use_address(void *base, size_t size, int fd ATTRIBUTE_UNUSED,
                                size_t offset ATTRIBUTE_UNUSED) {
   void *addr = xmalloc(size);
-  return (addr == base) - 1;
+  if (addr == base)
+    return 0;
+  free(addr);
+  return -1;
 }
 
 /* Default version of HOST_HOOKS_GT_PCH_GET_ADDRESS.   Return the
@@ -62,6 +62,33 @@ along with GCC; see the file COPYING3.  If not see
 #define USING_MALLOC_PAGE_GROUPS
 #endif
 
+/* With madvise, free pages can be given back to the system without
+   unmapping them.  */
+#if defined(USING_MMAP) && defined(HAVE_MADVISE) && defined(MADV_DONTNEED)
+#define USING_MADVISE
+
+#ifdef MADV_HUGEPAGE
+#define USING_HUGE_PAGES
+
+/* The size of the huge pages to ask for, and of the aligned regions
+   that single pages are then taken from.  */
+#define HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024)
+#endif
+#endif
+
+/* With mprotect and a SIGSEGV handler that is told the faulting
+   address, the pages that survived the last collection can be made
+   read-only so that the next write to each of them is noticed.  A
+   minor collection then marks and sweeps only the pages allocated
+   since, and looks for pointers to their objects only in the old
+   pages that have been written to.  */
+#ifdef USING_MMAP
+#include <signal.h>
+#if defined(SA_SIGINFO) && !defined(ENABLE_GC_ALWAYS_COLLECT)
+#define USING_WRITE_BARRIER
+#endif
+#endif
+
 /* Strategy:
 
    This garbage-collecting allocator allocates objects on one of a set
@@ -146,6 +173,10 @@ along with GCC; see the file COPYING3.  If not see
 /* The size of an object on a page of the indicated ORDER.  */
 #define OBJECT_SIZE(ORDER) object_size_table[ORDER]
 
+/* The number of page ages that -fmem-report tells apart; older pages
+   are counted with the last.  */
+#define NUM_PAGE_AGES 8
+
 /* For speed, we avoid doing a general integer divide to locate the
    offset in the allocation bitmap, by precalculating numbers M, S
    such that (O * M) >> S == O / Z (modulo 2^32), for any offset O
@@ -272,6 +303,22 @@ typedef struct page_entry {
   /* The lg of size of objects allocated from this page.  */
   unsigned char order;
 
+  /* The number of collections after which this page still held live
+     objects, saturating at UCHAR_MAX.  */
+  unsigned char collections_survived;
+
+#ifdef USING_WRITE_BARRIER
+  /* True if this page is mapped read-only, so that it has not been
+     written to since the last collection.  */
+  bool write_protected;
+#endif
+
+#ifdef USING_MADVISE
+  /* True if this page is on the free list and its memory has been
+     given back to the system.  */
+  bool discarded;
+#endif
+
   /* A bit vector indicating whether or not objects are in use.  The
      Nth bit is one if the Nth object on this page is allocated.  This
      array is dynamically sized.  */
@@ -340,6 +387,14 @@ static struct globals {
   /* Bytes currently allocated at the end of the last collection.  */
   size_t allocated_last_gc;
 
+  /* The heap expansion, as a percentage of allocated_last_gc, after
+     which to collect again when --param ggc-max-expand lets it adapt.  */
+  unsigned int expand;
+
+  /* True if ggc_collect should leave the densest pages with free
+     objects at the head of each list.  */
+  bool prefer_dense_pages;
+
   /* Total amount of memory mapped.  */
   size_t bytes_mapped;
 
@@ -405,6 +460,39 @@ static struct globals {
   } *free_object_list;
 #endif
 
+  /* The number of collections, and the time in microseconds spent
+     marking and sweeping in them, for -fmem-report.  */
+  unsigned long collections;
+  unsigned long long mark_time;
+  unsigned long long sweep_time;
+
+  /* True while a collection marks and sweeps only the pages allocated
+     since the last collection.  */
+  bool minor_collection;
+
+  /* The number of those minor collections, for -fmem-report.  */
+  unsigned long minor_collections;
+
+#ifdef USING_WRITE_BARRIER
+  /* True if the last collection left all the pages that could be
+     protected read-only, so that a minor collection may follow.  */
+  bool pages_protected;
+
+  /* The number of minor collections since the last full one.  */
+  unsigned int minor_since_full;
+
+  /* Young objects found from the pages written to, whose own contents
+     remain to be scanned.  */
+  const char **young_stack;
+  size_t young_stack_depth;
+  size_t young_stack_alloc;
+
+  /* True once write_fault is installed, and the SIGSEGV action it
+     replaced.  */
+  bool write_fault_installed;
+  struct sigaction old_segv_action;
+#endif
+
 #ifdef GATHER_STATISTICS
   struct {
     /* Total memory allocated with ggc_alloc.  */
@@ -471,10 +559,20 @@ static void free_page(struct page_entry *);
 static void release_pages(void);
 static void clear_marks(void);
 static void sweep_pages(void);
+static void sort_pages_by_density(void);
 static void ggc_recalculate_in_use_p(page_entry *);
 static void compute_inverse(unsigned);
 static inline void adjust_depth(void);
-static void move_ptes_to_front(int, int);
+static void move_ptes_to_front(int, int, int);
+static inline bool young_page_p(const page_entry *);
+#ifdef USING_WRITE_BARRIER
+static void write_fault(int, siginfo_t *, void *);
+static int compare_page_addresses(const void *, const void *);
+static void protect_pages(void);
+static void unprotect_pages(void);
+static void mark_young_pointers(const char *, size_t);
+static void mark_from_written_pages(void);
+#endif
 
 void debug_print_page_list(int);
 static void push_depth(unsigned int);
@@ -643,6 +741,26 @@ static inline char *alloc_anon(char *pref ATTRIBUTE_UNUSED, size_t size) {
   return page;
 }
 #endif
+#ifdef USING_HUGE_PAGES
+/* Allocate SIZE bytes of anonymous memory aligned to SIZE, which is a
+   multiple of HUGE_PAGE_SIZE, and ask for huge pages to back it.  */
+
+static char *alloc_anon_huge(size_t size) {
+  char *allocation = alloc_anon(NULL, 2 * size);
+  char *page = (char *)(((size_t)allocation + size - 1) & ~(size - 1));
+  size_t head_slop = page - allocation;
+  size_t tail_slop = size - head_slop;
+
+  if (head_slop)
+    munmap(allocation, head_slop);
+  if (tail_slop)
+    munmap(page + size, tail_slop);
+  G.bytes_mapped -= size;
+
+  madvise(page, size, MADV_HUGEPAGE);
+  return page;
+}
+#endif
 #ifdef USING_MALLOC_PAGE_GROUPS
 /* Compute the index for this page into the page group.  */
 
@@ -696,6 +814,10 @@ static inline struct page_entry *alloc_page(unsigned order) {
     *pp = p->next;
     page = p->page;
 
+#ifdef USING_MADVISE
+    if (p->discarded)
+      G.bytes_mapped += p->bytes;
+#endif
 #ifdef USING_MALLOC_PAGE_GROUPS
     group = p->group;
 #endif
@@ -713,13 +835,21 @@ static inline struct page_entry *alloc_page(unsigned order) {
        extras on the freelist.  (Can only do this optimization with
        mmap for backing store.)  */
     struct page_entry *e, *f = G.free_pages;
-    int i;
-
-    page = alloc_anon(NULL, G.pagesize * GGC_QUIRE_SIZE);
+    int i, quire_size = GGC_QUIRE_SIZE;
+
+#ifdef USING_HUGE_PAGES
+    /* The first pages are allocated before the params are registered.  */
+    if (compiler_params != NULL && PARAM_VALUE(GGC_HUGE_PAGES) &&
+        HUGE_PAGE_SIZE > G.pagesize) {
+      quire_size = HUGE_PAGE_SIZE >> G.lg_pagesize;
+      page = alloc_anon_huge(HUGE_PAGE_SIZE);
+    } else
+#endif
+      page = alloc_anon(NULL, G.pagesize * quire_size);
 
     /* This loop counts down so that the chain will be in ascending
        memory order.  */
-    for (i = GGC_QUIRE_SIZE - 1; i >= 1; i--) {
+    for (i = quire_size - 1; i >= 1; i--) {
       e = XCNEWVAR(struct page_entry, page_entry_size);
       e->order = order;
       e->bytes = G.pagesize;
@@ -807,6 +937,7 @@ static inline struct page_entry *alloc_page(unsigned order) {
   entry->order = order;
   entry->num_free_objects = num_objects;
   entry->next_bit_hint = 1;
+  entry->collections_survived = 0;
 
   G.context_depth_allocations |= (unsigned long)1 << G.context_depth;
 
@@ -848,6 +979,111 @@ static inline void adjust_depth(void) {
   }
 }
 
+/* Return true if the objects on page P have all been allocated since
+   the last collection.  Pages that survived a collection, and those of
+   outer contexts, are old.  */
+
+static inline bool young_page_p(const page_entry *p) {
+  return p->collections_survived == 0 && p->context_depth == G.context_depth;
+}
+
+#ifdef USING_WRITE_BARRIER
+/* Handle a fault on the page at INFO->si_addr.  If it is a page that
+   protect_pages made read-only, make it writable again, which notes
+   that it has been written to, and let the write go ahead.  Otherwise
+   reinstate the previous handler, which then sees the fault again.  */
+
+static void write_fault(int sig ATTRIBUTE_UNUSED, siginfo_t *info,
+                        void *context ATTRIBUTE_UNUSED) {
+  const char *addr = (const char *)info->si_addr;
+
+  if (ggc_allocated_p(addr)) {
+    page_entry *p = lookup_page_table_entry(addr);
+
+    if (p->write_protected &&
+        mprotect(p->page, p->bytes, PROT_READ | PROT_WRITE) == 0) {
+      p->write_protected = false;
+      return;
+    }
+  }
+
+  sigaction(SIGSEGV, &G.old_segv_action, NULL);
+}
+
+/* Compare the page entries at A and B by address.  */
+
+static int compare_page_addresses(const void *a, const void *b) {
+  const page_entry *pa = *(const page_entry *const *)a;
+  const page_entry *pb = *(const page_entry *const *)b;
+
+  return pa->page < pb->page ? -1 : pa->page > pb->page;
+}
+
+/* Make every page read-only, so that the pages written to before the
+   next collection are known.  A page is left writable if the page
+   table does not cover its last system page, as for a large object,
+   since write_fault could not find it; such a page is scanned at every
+   minor collection.  Adjacent pages are protected together.  */
+
+static void protect_pages(void) {
+  page_entry **pages;
+  size_t i, j, n = 0;
+
+  if (!G.write_fault_installed) {
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = write_fault;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, &G.old_segv_action) != 0)
+      return;
+    G.write_fault_installed = true;
+  }
+
+  pages = XNEWVEC(page_entry *, G.by_depth_in_use);
+  for (i = 0; i < G.by_depth_in_use; i++) {
+    page_entry *p = G.by_depth[i];
+    const char *last = p->page + p->bytes - G.pagesize;
+
+    if (!p->write_protected && ggc_allocated_p(last) &&
+        lookup_page_table_entry(last) == p)
+      pages[n++] = p;
+  }
+  qsort(pages, n, sizeof(page_entry *), compare_page_addresses);
+
+  for (i = 0; i < n; i = j) {
+    char *end = pages[i]->page + pages[i]->bytes;
+
+    for (j = i + 1; j < n && pages[j]->page == end; j++)
+      end += pages[j]->bytes;
+    if (mprotect(pages[i]->page, end - pages[i]->page, PROT_READ) == 0)
+      for (; i < j; i++)
+        pages[i]->write_protected = true;
+  }
+
+  free(pages);
+  G.pages_protected = true;
+}
+
+/* Make every page writable again, and have the next collection be a
+   full one.  */
+
+static void unprotect_pages(void) {
+  size_t i;
+
+  for (i = 0; i < G.by_depth_in_use; i++) {
+    page_entry *p = G.by_depth[i];
+
+    if (p->write_protected) {
+      mprotect(p->page, p->bytes, PROT_READ | PROT_WRITE);
+      p->write_protected = false;
+    }
+  }
+  G.pages_protected = false;
+}
+#endif
+
 /* For a page that is no longer needed, put it on the free page list.  */
 
 static void free_page(page_entry *entry) {
@@ -861,6 +1097,13 @@ static void free_page(page_entry *entry) {
 
   set_page_table_entry(entry->page, NULL);
 
+#ifdef USING_WRITE_BARRIER
+  if (entry->write_protected) {
+    mprotect(entry->page, entry->bytes, PROT_READ | PROT_WRITE);
+    entry->write_protected = false;
+  }
+#endif
+
 #ifdef USING_MALLOC_PAGE_GROUPS
   clear_page_group_in_use(entry->group, entry->page);
 #endif
@@ -889,7 +1132,50 @@ static void free_page(page_entry *entry) {
 /* Release the free page cache to the system.  */
 
 static void release_pages(void) {
-#ifdef USING_MMAP
+#ifdef USING_MADVISE
+  page_entry **pp, *p, *first;
+  char *start;
+  size_t len;
+
+  /* Unmap the free pages that are larger than a system page.  They are
+     reused only for objects of the same size, and keeping them would
+     let the free list grow without bound.  */
+  pp = &G.free_pages;
+  while ((p = *pp) != NULL)
+    if (p->bytes != G.pagesize) {
+      *pp = p->next;
+      munmap(p->page, p->bytes);
+      if (!p->discarded)
+        G.bytes_mapped -= p->bytes;
+      free(p);
+    } else
+      pp = &p->next;
+
+  /* Keep the mappings of single pages for later allocations, but let
+     the system reclaim their memory.  Gather up adjacent pages so that
+     they are released together.  */
+  p = G.free_pages;
+  while (p) {
+    if (p->discarded) {
+      p = p->next;
+      continue;
+    }
+
+    first = p;
+    start = p->page;
+    len = p->bytes;
+    p = p->next;
+    while (p && !p->discarded && p->page == start + len) {
+      len += p->bytes;
+      p = p->next;
+    }
+
+    madvise(start, len, MADV_DONTNEED);
+    G.bytes_mapped -= len;
+    for (; first != p; first = first->next)
+      first->discarded = true;
+  }
+#elif defined(USING_MMAP)
   page_entry *p, *next;
   char *start;
   size_t len;
@@ -1154,6 +1440,26 @@ void *ggc_alloc_stat(size_t size MEM_STAT_DECL) {
   return result;
 }
 
+/* Set the in-use bit MASK in word WORD of the bitmap of ENTRY, and
+   account for one object fewer being free.  Return true if the bit was
+   already set.  */
+
+static inline bool set_in_use_bit(page_entry *entry, unsigned word,
+                                  unsigned long mask) {
+#ifdef GGC_PARALLEL_MARK
+  /* Other threads may be marking objects on the same page.  The free
+     object counts are recomputed once they are done.  */
+  if (ggc_mark_threads > 1)
+    return (__sync_fetch_and_or(&entry->in_use_p[word], mask) & mask) != 0;
+#endif
+
+  if (entry->in_use_p[word] & mask)
+    return true;
+  entry->in_use_p[word] |= mask;
+  entry->num_free_objects -= 1;
+  return false;
+}
+
 /* Mark function for strings.  */
 
 void gt_ggc_m_S(const void *p) {
@@ -1189,13 +1495,9 @@ void gt_ggc_m_S(const void *p) {
   mask = (unsigned long)1 << (bit % HOST_BITS_PER_LONG);
 
   /* If the bit was previously set, skip it.  */
-  if (entry->in_use_p[word] & mask)
+  if (set_in_use_bit(entry, word, mask))
     return;
 
-  /* Otherwise set it, and decrement the free object count.  */
-  entry->in_use_p[word] |= mask;
-  entry->num_free_objects -= 1;
-
   if (GGC_DEBUG_LEVEL >= 4)
     fprintf(G.debug_file, "Marking %p\n", p);
 
@@ -1223,13 +1525,9 @@ int ggc_set_mark(const void *p) {
   mask = (unsigned long)1 << (bit % HOST_BITS_PER_LONG);
 
   /* If the bit was previously set, skip it.  */
-  if (entry->in_use_p[word] & mask)
+  if (set_in_use_bit(entry, word, mask))
     return 1;
 
-  /* Otherwise set it, and decrement the free object count.  */
-  entry->in_use_p[word] |= mask;
-  entry->num_free_objects -= 1;
-
   if (GGC_DEBUG_LEVEL >= 4)
     fprintf(G.debug_file, "Marking %p\n", p);
 
@@ -1505,6 +1803,80 @@ static void ggc_recalculate_in_use_p(page_entry *p) {
   gcc_assert(p->num_free_objects < num_objects);
 }
 
+#ifdef USING_WRITE_BARRIER
+/* Mark the young objects that the SIZE bytes at START may point to, and
+   queue them to be scanned in turn.  Every aligned word is taken to be
+   a pointer, to the start or into the middle of an object.  */
+
+static void mark_young_pointers(const char *start, size_t size) {
+  const char *const *word = (const char *const *)start;
+  const char *const *end = word + size / sizeof(*word);
+
+  for (; word < end; word++) {
+    const char *q = *word;
+    page_entry *entry;
+    size_t bit;
+
+    if (!ggc_allocated_p(q))
+      continue;
+    entry = lookup_page_table_entry(q);
+    if (!young_page_p(entry))
+      continue;
+
+    bit = (size_t)(q - entry->page) / OBJECT_SIZE(entry->order);
+    if (bit >= OBJECTS_IN_PAGE(entry) ||
+        set_in_use_bit(entry, bit / HOST_BITS_PER_LONG,
+                       (unsigned long)1 << (bit % HOST_BITS_PER_LONG)))
+      continue;
+
+    if (G.young_stack_depth == G.young_stack_alloc) {
+      G.young_stack_alloc = G.young_stack_alloc ? G.young_stack_alloc * 2 : 256;
+      G.young_stack =
+          XRESIZEVEC(const char *, G.young_stack, G.young_stack_alloc);
+    }
+    G.young_stack[G.young_stack_depth++] =
+        entry->page + bit * OBJECT_SIZE(entry->order);
+  }
+}
+
+/* Before a minor collection marks from the roots, mark the young
+   objects reachable from the objects on old pages written to since the
+   last collection.  Only such writes can have stored pointers to young
+   objects in old ones.  Their contents are not known, so they are
+   scanned conservatively; at worst that keeps some garbage until the
+   next full collection.  */
+
+static void mark_from_written_pages(void) {
+  unsigned order;
+
+  G.young_stack_depth = 0;
+  for (order = 2; order < NUM_ORDERS; order++) {
+    size_t size = OBJECT_SIZE(order);
+    page_entry *p;
+
+    for (p = G.pages[order]; p != NULL; p = p->next) {
+      size_t num_objects, i;
+
+      if (p->write_protected || young_page_p(p))
+        continue;
+
+      num_objects = OBJECTS_IN_PAGE(p);
+      for (i = 0; i < num_objects; i++)
+        if ((p->in_use_p[i / HOST_BITS_PER_LONG] >> (i % HOST_BITS_PER_LONG)) &
+            1)
+          mark_young_pointers(p->page + i * size, size);
+    }
+  }
+
+  while (G.young_stack_depth > 0) {
+    const char *object = G.young_stack[--G.young_stack_depth];
+
+    mark_young_pointers(object,
+                        OBJECT_SIZE(lookup_page_table_entry(object)->order));
+  }
+}
+#endif
+
 /* Unmark all objects.  */
 
 static void clear_marks(void) {
@@ -1520,6 +1892,11 @@ static void clear_marks(void) {
       /* The data should be page-aligned.  */
       gcc_assert(!((size_t)p->page & (G.pagesize - 1)));
 
+      /* A minor collection keeps the in-use bits of the old pages, so
+         that marking stops at their objects.  */
+      if (G.minor_collection && !young_page_p(p))
+        continue;
+
       /* Pages that aren't in the topmost context are not collected;
          nevertheless, we need their in-use bit vectors to store GC
          marks.  So, back them up first.  */
@@ -1541,6 +1918,31 @@ static void clear_marks(void) {
   }
 }
 
+#ifdef GGC_PARALLEL_MARK
+/* Set the free object counts from the mark bits, after marking with
+   several threads.  */
+
+static void recount_free_objects(void) {
+  unsigned order;
+
+  for (order = 2; order < NUM_ORDERS; order++) {
+    page_entry *p;
+
+    for (p = G.pages[order]; p != NULL; p = p->next) {
+      size_t num_objects = OBJECTS_IN_PAGE(p);
+      size_t words = BITMAP_SIZE(num_objects + 1) / sizeof(long);
+      size_t i, marked = 0;
+
+      for (i = 0; i < words; i++)
+        marked += __builtin_popcountl(p->in_use_p[i]);
+
+      /* Do not count the one-past-the-end bit.  */
+      p->num_free_objects = num_objects - (marked - 1);
+    }
+  }
+}
+#endif
+
 /* Free all empty pages.  Partially empty pages need no attention
    because the `mark' bit doubles as an `unused' bit.  */
 
@@ -1576,6 +1978,9 @@ static void sweep_pages(void) {
 
       G.allocated += OBJECT_SIZE(order) * live_objects;
 
+      if (live_objects != 0 && p->collections_survived < UCHAR_MAX)
+        p->collections_survived++;
+
       /* Only objects on pages in the topmost context should get
          collected.  */
       if (p->context_depth < G.context_depth)
@@ -1658,10 +2063,12 @@ static void sweep_pages(void) {
     } while (!done);
 
     /* Now, restore the in_use_p vectors for any pages from contexts
-       other than the current one.  */
-    for (p = G.pages[order]; p; p = p->next)
-      if (p->context_depth != G.context_depth)
-        ggc_recalculate_in_use_p(p);
+       other than the current one.  A minor collection did not clear
+       them.  */
+    if (!G.minor_collection)
+      for (p = G.pages[order]; p; p = p->next)
+        if (p->context_depth != G.context_depth)
+          ggc_recalculate_in_use_p(p);
   }
 }
 
@@ -1686,6 +2093,11 @@ static void poison_pages(void) {
            contexts.  */
         continue;
 
+      /* The free objects on old pages were poisoned when they were
+         freed, and a minor collection frees none of them.  */
+      if (G.minor_collection && !young_page_p(p))
+        continue;
+
       num_objects = OBJECTS_IN_PAGE(p);
       for (i = 0; i < num_objects; i++) {
         size_t word, bit;
@@ -1747,6 +2159,32 @@ static void validate_free_objects(void) {
 #define validate_free_objects()
 #endif
 
+/* Return a time in microseconds, for timing the phases of a
+   collection.  */
+
+static unsigned long long ggc_time(void) {
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+
+  if (gettimeofday(&tv, NULL) == 0)
+    return (unsigned long long)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+  return get_run_time();
+}
+
+/* Return the heap expansion, as a percentage, after which ggc_collect
+   collects again.  This adapts to the survival rate of the collections
+   when --param ggc-max-expand is above ggc-min-expand.  */
+
+static unsigned int collection_expand(void) {
+  unsigned int min_expand = PARAM_VALUE(GGC_MIN_EXPAND);
+  unsigned int max_expand = PARAM_VALUE(GGC_MAX_EXPAND);
+
+  if (max_expand <= min_expand)
+    return min_expand;
+  return MIN(MAX(G.expand, min_expand), max_expand);
+}
+
 /* Top level mark-and-sweep routine.  */
 
 void ggc_collect(void) {
@@ -1756,7 +2194,9 @@ void ggc_collect(void) {
   float allocated_last_gc =
       MAX(G.allocated_last_gc, (size_t)PARAM_VALUE(GGC_MIN_HEAPSIZE) * 1024);
 
-  float min_expand = allocated_last_gc * PARAM_VALUE(GGC_MIN_EXPAND) / 100;
+  float min_expand = allocated_last_gc * collection_expand() / 100;
+  size_t allocated_before = G.allocated;
+  unsigned long long mark_start, sweep_start;
 
   if (G.allocated < allocated_last_gc + min_expand && !ggc_force_collect)
     return;
@@ -1778,14 +2218,67 @@ void ggc_collect(void) {
   /* Indicate that we've seen collections at this context depth.  */
   G.context_depth_collections = ((unsigned long)1 << (G.context_depth + 1)) - 1;
 
+  mark_start = ggc_time();
+#ifdef GGC_PARALLEL_MARK
+  ggc_mark_threads = PARAM_VALUE(GGC_MARK_THREADS);
+#endif
+#ifdef USING_WRITE_BARRIER
+  /* Between full collections, do --param ggc-minor-collections minor
+     ones, which can rely on the pages written to since the previous
+     collection being known.  */
+  if (G.pages_protected &&
+      G.minor_since_full < (unsigned int)PARAM_VALUE(GGC_MINOR_COLLECTIONS)) {
+    G.minor_collection = true;
+    G.minor_since_full++;
+    G.minor_collections++;
+  } else
+    G.minor_since_full = 0;
+#endif
   clear_marks();
+#ifdef USING_WRITE_BARRIER
+  if (G.minor_collection)
+    mark_from_written_pages();
+#endif
   ggc_mark_roots();
+#ifdef GGC_PARALLEL_MARK
+  if (ggc_mark_threads > 1)
+    recount_free_objects();
+  ggc_mark_threads = 1;
+#endif
 #ifdef GATHER_STATISTICS
   ggc_prune_overhead_list();
 #endif
+
+  sweep_start = ggc_time();
   poison_pages();
   validate_free_objects();
   sweep_pages();
+  if (G.prefer_dense_pages)
+    sort_pages_by_density();
+#ifdef USING_WRITE_BARRIER
+  G.minor_collection = false;
+  if (PARAM_VALUE(GGC_MINOR_COLLECTIONS))
+    protect_pages();
+#endif
+
+  G.collections++;
+  G.mark_time += sweep_start - mark_start;
+  G.sweep_time += ggc_time() - sweep_start;
+
+  /* If most of what was allocated since the last collection survived
+     this one, collecting was largely wasted work, so let the heap grow
+     further before the next one.  If little of it did, collect sooner.  */
+  if (allocated_before > G.allocated_last_gc) {
+    size_t allocated_since = allocated_before - G.allocated_last_gc;
+    size_t survived = (G.allocated > G.allocated_last_gc
+                           ? G.allocated - G.allocated_last_gc
+                           : 0);
+
+    if (survived > allocated_since / 2)
+      G.expand = collection_expand() * 2;
+    else
+      G.expand = collection_expand() / 2;
+  }
 
   G.allocated_last_gc = G.allocated;
 
@@ -1797,6 +2290,78 @@ void ggc_collect(void) {
     fprintf(G.debug_file, "END COLLECTING\n");
 }
 
+/* Compare the page entries at A and B, putting the one with fewer free
+   objects first.  */
+
+static int compare_free_objects(const void *a, const void *b) {
+  const page_entry *pa = *(const page_entry *const *)a;
+  const page_entry *pb = *(const page_entry *const *)b;
+
+  if (pa->num_free_objects != pb->num_free_objects)
+    return pa->num_free_objects < pb->num_free_objects ? -1 : 1;
+  return pa->page < pb->page ? -1 : pa->page > pb->page;
+}
+
+/* Sort the pages of the current context that have free objects, which
+   are at the head of each list, so that ggc_alloc_stat fills the
+   densest of them first.  */
+
+static void sort_pages_by_density(void) {
+  page_entry **pages = NULL;
+  size_t n_alloc = 0;
+  unsigned order;
+
+  for (order = 2; order < NUM_ORDERS; order++) {
+    page_entry *p, *rest;
+    size_t i, n = 0;
+
+    for (p = G.pages[order]; p != NULL; p = p->next)
+      if (p->context_depth != G.context_depth || p->num_free_objects == 0)
+        break;
+      else
+        n++;
+    if (n < 2)
+      continue;
+    rest = p;
+
+    if (n > n_alloc) {
+      n_alloc = n;
+      pages = XRESIZEVEC(page_entry *, pages, n_alloc);
+    }
+    for (i = 0, p = G.pages[order]; i < n; i++, p = p->next)
+      pages[i] = p;
+    qsort(pages, n, sizeof(page_entry *), compare_free_objects);
+
+    /* Relink the sorted pages in front of the rest of the list.  */
+    G.pages[order] = pages[0];
+    pages[0]->prev = NULL;
+    for (i = 1; i < n; i++) {
+      pages[i - 1]->next = pages[i];
+      pages[i]->prev = pages[i - 1];
+    }
+    pages[n - 1]->next = rest;
+    if (rest)
+      rest->prev = pages[n - 1];
+    else
+      G.page_tails[order] = pages[n - 1];
+  }
+
+  free(pages);
+}
+
+/* Objects are never moved, so this only keeps fragmentation from
+   growing: sparse pages get no new objects and are released once
+   their last object dies.  Each collection sorts the pages again.
+   Moving objects would not be held back by the stack, since the
+   collector only runs where no GC pointers are live there, but by the
+   many hash tables keyed on object addresses, which would all need
+   rehashing afterwards.  */
+
+void ggc_prefer_dense_pages(void) {
+  G.prefer_dense_pages = true;
+  sort_pages_by_density();
+}
+
 /* Print allocation statistics.  */
 #define SCALE(x)                                              \
   ((unsigned long)((x) < 1024 * 10                            \
@@ -1862,6 +2427,32 @@ void ggc_print_statistics(void) {
           SCALE(G.bytes_mapped), STAT_LABEL(G.bytes_mapped), SCALE(G.allocated),
           STAT_LABEL(G.allocated), SCALE(total_overhead),
           STAT_LABEL(total_overhead));
+  fprintf(stderr,
+          "%lu collections (%lu minor): %.3f s marking, %.3f s sweeping\n",
+          G.collections, G.minor_collections, G.mark_time / 1e6,
+          G.sweep_time / 1e6);
+
+  /* Show how much of the memory in use sits on pages that have
+     survived many collections, which minor collections do not mark
+     again.  */
+  {
+    size_t by_age[NUM_PAGE_AGES];
+
+    memset(by_age, 0, sizeof(by_age));
+    for (i = 0; i < NUM_ORDERS; ++i) {
+      page_entry *p;
+
+      for (p = G.pages[i]; p; p = p->next)
+        by_age[MIN(p->collections_survived, NUM_PAGE_AGES - 1)] +=
+            (OBJECTS_IN_PAGE(p) - p->num_free_objects) * OBJECT_SIZE(i);
+    }
+
+    fprintf(stderr, "\nMemory in use by collections survived by its page\n");
+    for (i = 0; i < NUM_PAGE_AGES; ++i)
+      fprintf(stderr, "%2u%-3s %10lu%c\n", i,
+              i == NUM_PAGE_AGES - 1 ? "+" : "", SCALE(by_age[i]),
+              STAT_LABEL(by_age[i]));
+  }
 
 #ifdef GATHER_STATISTICS
   {
@@ -2023,11 +2614,14 @@ void ggc_pch_finish(struct ggc_pch_data *d, FILE *f) {
 }
 
 /* Move the PCH PTE entries just added to the end of by_depth, to the
-   front.  */
+   front, after the COUNT_PCH_PAGE_TABLES entries of any PCH file read
+   before.  */
 
-static void move_ptes_to_front(int count_old_page_tables,
+static void move_ptes_to_front(int count_pch_page_tables,
+                               int count_old_page_tables,
                                int count_new_page_tables) {
   unsigned i;
+  int count_rest = count_old_page_tables - count_pch_page_tables;
 
   /* First, we swap the new entries to the front of the varrays.  */
   page_entry **new_by_depth;
@@ -2036,14 +2630,20 @@ static void move_ptes_to_front(int count_old_page_tables,
   new_by_depth = XNEWVEC(page_entry *, G.by_depth_max);
   new_save_in_use = XNEWVEC(unsigned long *, G.by_depth_max);
 
-  memcpy(&new_by_depth[0], &G.by_depth[count_old_page_tables],
+  memcpy(&new_by_depth[0], &G.by_depth[0],
+         count_pch_page_tables * sizeof(void *));
+  memcpy(&new_by_depth[count_pch_page_tables],
+         &G.by_depth[count_old_page_tables],
          count_new_page_tables * sizeof(void *));
-  memcpy(&new_by_depth[count_new_page_tables], &G.by_depth[0],
-         count_old_page_tables * sizeof(void *));
-  memcpy(&new_save_in_use[0], &G.save_in_use[count_old_page_tables],
+  memcpy(&new_by_depth[count_pch_page_tables + count_new_page_tables],
+         &G.by_depth[count_pch_page_tables], count_rest * sizeof(void *));
+  memcpy(&new_save_in_use[0], &G.save_in_use[0],
+         count_pch_page_tables * sizeof(void *));
+  memcpy(&new_save_in_use[count_pch_page_tables],
+         &G.save_in_use[count_old_page_tables],
          count_new_page_tables * sizeof(void *));
-  memcpy(&new_save_in_use[count_new_page_tables], &G.save_in_use[0],
-         count_old_page_tables * sizeof(void *));
+  memcpy(&new_save_in_use[count_pch_page_tables + count_new_page_tables],
+         &G.save_in_use[count_pch_page_tables], count_rest * sizeof(void *));
 
   free(G.by_depth);
   free(G.save_in_use);
@@ -2061,8 +2661,13 @@ static void move_ptes_to_front(int count_old_page_tables,
      entry is already 0, and context 0 entries always start at index
      0, so there is nothing to update in the first slot.  We need a
      second slot, only if we have old ptes, and if we do, they start
-     at index count_new_page_tables.  */
-  if (count_old_page_tables)
+     at index count_new_page_tables.  When an earlier PCH file was
+     read, the entries after it just move up.  */
+  if (count_pch_page_tables) {
+    for (i = 0; i < G.depth_in_use; i++)
+      if (G.depth[i] >= (unsigned)count_pch_page_tables)
+        G.depth[i] += count_new_page_tables;
+  } else if (count_old_page_tables)
     push_depth(count_new_page_tables);
 }
 
@@ -2072,9 +2677,25 @@ void ggc_pch_read(FILE *f, void *addr) {
   char *offs = (char *)addr;
   unsigned long count_old_page_tables;
   unsigned long count_new_page_tables;
+  unsigned long count_pch_page_tables = 0;
 
   count_old_page_tables = G.by_depth_in_use;
 
+#ifdef USING_WRITE_BARRIER
+  /* The pages of an earlier PCH file are written to directly while
+     this one is read.  */
+  unprotect_pages();
+#endif
+
+  /* A PCH file may be read on top of one read earlier, whose pages
+     stay at depth 0 and remain live.  */
+  if (G.context_depth) {
+    gcc_assert(G.context_depth == 1);
+    while (count_pch_page_tables < count_old_page_tables &&
+           G.by_depth[count_pch_page_tables]->context_depth == 0)
+      count_pch_page_tables++;
+  }
+
   /* We've just read in a PCH file.  So, every object that used to be
      allocated is now free.  */
   clear_marks();
@@ -2085,15 +2706,26 @@ void ggc_pch_read(FILE *f, void *addr) {
      useless.  Validate it now, which will also clear it.  */
   validate_free_objects();
 
+  /* clear_marks backed up the in-use bits of the pages read from an
+     earlier PCH file; those objects are still live.  */
+  for (i = 0; i < count_pch_page_tables; i++) {
+    page_entry *p = G.by_depth[i];
+    memcpy(p->in_use_p, save_in_use_p_i(i),
+           BITMAP_SIZE(OBJECTS_IN_PAGE(p) + 1));
+    p->num_free_objects = 0;
+  }
+
   /* No object read from a PCH file should ever be freed.  So, set the
      context depth to 1, and set the depth of all the currently-allocated
-     pages to be 1 too.  PCH pages will have depth 0.  */
-  gcc_assert(!G.context_depth);
-  G.context_depth = 1;
-  for (i = 0; i < NUM_ORDERS; i++) {
-    page_entry *p;
-    for (p = G.pages[i]; p != NULL; p = p->next)
-      p->context_depth = G.context_depth;
+     pages to be 1 too.  PCH pages will have depth 0.  After an earlier
+     PCH file this has been done already.  */
+  if (!G.context_depth) {
+    G.context_depth = 1;
+    for (i = 0; i < NUM_ORDERS; i++) {
+      page_entry *p;
+      for (p = G.pages[i]; p != NULL; p = p->next)
+        p->context_depth = G.context_depth;
+    }
   }
 
   /* Allocate the appropriate page-table entries for the pages read from
@@ -2148,8 +2780,12 @@ void ggc_pch_read(FILE *f, void *addr) {
      handling.  */
   count_new_page_tables = G.by_depth_in_use - count_old_page_tables;
 
-  move_ptes_to_front(count_old_page_tables, count_new_page_tables);
+  move_ptes_to_front(count_pch_page_tables, count_old_page_tables,
+                     count_new_page_tables);
 
-  /* Update the statistics.  */
-  G.allocated = G.allocated_last_gc = offs - (char *)addr;
+  /* Update the statistics.  Only the PCH pages hold live objects.  */
+  G.allocated = offs - (char *)addr;
+  for (i = 0; i < count_pch_page_tables; i++)
+    G.allocated += G.by_depth[i]->bytes;
+  G.allocated_last_gc = G.allocated;
 }
@@ -1894,6 +1894,11 @@ void ggc_collect(void) {
   timevar_pop(TV_GC);
 }
 
+/* Allocation already fills each zone in address order, so there is
+   nothing to do here.  */
+
+void ggc_prefer_dense_pages(void) {}
+
 /* Print allocation statistics.  */
 #define SCALE(x)                                              \
   ((unsigned long)((x) < 1024 * 10                            \
@@ -2229,6 +2234,12 @@ void ggc_pch_read(FILE *f, void *addr) {
   struct page_entry *pch_page;
   char *p;
 
+  /* The zone collector has a single PCH zone, so it cannot stack one
+     PCH file on top of another.  */
+  if (pch_zone.page)
+    fatal_error("chained precompiled headers are not supported "
+                "with the zone collector");
+
   if (fread(&d, sizeof(d), 1, f) != 1)
     fatal_error("can't read PCH file: %m");
 
@@ -33,8 +33,11 @@ extern const char digit_vector[]; /* "0" .. "9" */
 /* Internal functions and data structures used by the GTY
    machinery.  */
 
-/* The first parameter is a pointer to a pointer, the second a cookie.  */
-typedef void (*gt_pointer_operator)(void *, void *);
+/* The first parameter is a pointer to a pointer, the third a cookie.
+   The second is NULL, or, if the first points to a temporary that holds
+   a nested pointer converted from the object, the field the converted
+   value is stored back into.  */
+typedef void (*gt_pointer_operator)(void *, void *, void *);
 
 #include "gtype-desc.h"
 
@@ -127,6 +130,17 @@ extern void ggc_purge_stringpool(void);
 
 extern void ggc_mark_roots(void);
 
+/* Whether the roots can be marked by several threads.  This needs the
+   __sync builtins to set mark bits atomically.  */
+#if defined(HAVE_PTHREAD) && GCC_VERSION >= 4001
+#define GGC_PARALLEL_MARK 1
+#endif
+
+/* The number of threads with which ggc_mark_roots marks the roots.  A
+   collector sets this above one only when its ggc_set_mark and
+   gt_ggc_m_S can run in several threads at once.  */
+extern int ggc_mark_threads;
+
 /* Save and restore the string pool entries for PCH.  */
 
 extern void gt_pch_save_stringpool(void);
@@ -268,14 +282,20 @@ extern const char *ggc_alloc_string(const char *contents, int length);
    function is called, not during allocations.  */
 extern void ggc_collect(void);
 
+/* From now on, have new objects fill the most densely used pages
+   first, so that sparsely used pages can empty out and be released.  */
+extern void ggc_prefer_dense_pages(void);
+
 /* Return the number of bytes allocated at the indicated address.  */
 extern size_t ggc_get_size(const void *);
 
-/* Write out all GCed objects to F.  */
-extern void gt_pch_save(FILE *f);
+/* Write out all GCed objects to F.  If CHAIN, the file is a layer over
+   the PCH files already read, and holds only what changed since.  */
+extern void gt_pch_save(FILE *f, bool chain);
 
-/* Read objects previously saved with gt_pch_save from F.  */
-extern void gt_pch_restore(FILE *f);
+/* Read objects previously saved with gt_pch_save from F.  If KEEP, keep
+   a copy of them so that a layer can be written over them later.  */
+extern void gt_pch_restore(FILE *f, bool keep);
 
 /* Statistics.  */
 
@@ -129,7 +129,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "diagnostic.h"
 #include "timevar.h"
 #include "params.h"
-#include "fibheap.h"
+#include "idxheap.h"
 #include "intl.h"
 #include "tree-pass.h"
 #include "hashtab.h"
@@ -519,7 +519,7 @@ static int cgraph_edge_badness(struct cgraph_edge *edge) {
 
 /* Recompute heap nodes for each of caller edge.  */
 
-static void update_caller_keys(fibheap_t heap, struct cgraph_node *node,
+static void update_caller_keys(idxheap_t heap, struct cgraph_node *node,
                                bitmap updated_nodes) {
   struct cgraph_edge *edge;
   const char *failed_reason;
@@ -538,7 +538,7 @@ static void update_caller_keys(fibheap_t heap, struct cgraph_node *node,
   if (!cgraph_default_inline_p(node, &failed_reason)) {
     for (edge = node->callers; edge; edge = edge->next_caller)
       if (edge->aux) {
-        fibheap_delete_node(heap, (fibnode_t)edge->aux);
+        idxheap_delete_node(heap, (idxnode_t)(size_t)edge->aux);
         edge->aux = NULL;
         if (edge->inline_failed)
           edge->inline_failed = failed_reason;
@@ -550,23 +550,18 @@ static void update_caller_keys(fibheap_t heap, struct cgraph_node *node,
     if (edge->inline_failed) {
       int badness = cgraph_edge_badness(edge);
       if (edge->aux) {
-        fibnode_t n = (fibnode_t)edge->aux;
-        gcc_assert(n->data == edge);
-        if (n->key == badness)
-          continue;
-
-        /* fibheap_replace_key only increase the keys.  */
-        if (fibheap_replace_key(heap, n, badness))
-          continue;
-        fibheap_delete_node(heap, (fibnode_t)edge->aux);
+        idxnode_t n = (idxnode_t)(size_t)edge->aux;
+        gcc_assert(idxheap_data(heap, n) == edge);
+        idxheap_replace_key(heap, n, badness);
+        continue;
       }
-      edge->aux = fibheap_insert(heap, badness, edge);
+      edge->aux = (void *)(size_t)idxheap_insert(heap, badness, edge);
     }
 }
 
 /* Recompute heap nodes for each of caller edges of each of callees.  */
 
-static void update_callee_keys(fibheap_t heap, struct cgraph_node *node,
+static void update_callee_keys(idxheap_t heap, struct cgraph_node *node,
                                bitmap updated_nodes) {
   struct cgraph_edge *e;
   node->global.estimated_growth = INT_MIN;
@@ -582,7 +577,7 @@ static void update_callee_keys(fibheap_t heap, struct cgraph_node *node,
    how likely we want to recursively inline the call.  */
 
 static void lookup_recursive_calls(struct cgraph_node *node,
-                                   struct cgraph_node *where, fibheap_t heap) {
+                                   struct cgraph_node *where, idxheap_t heap) {
   static int priority;
   struct cgraph_edge *e;
   for (e = where->callees; e; e = e->next_callee)
@@ -590,7 +585,7 @@ static void lookup_recursive_calls(struct cgraph_node *node,
       /* When profile feedback is available, prioritize by expected number
          of calls.  Without profile feedback we maintain simple queue
          to order candidates via recursive depths.  */
-      fibheap_insert(
+      idxheap_insert(
           heap,
           !max_count ? priority++
                      : -(e->count / ((max_count + (1 << 24) - 1) / (1 << 24))),
@@ -612,7 +607,7 @@ static bool cgraph_decide_recursive_inlining(struct cgraph_node *node,
   int limit = PARAM_VALUE(PARAM_MAX_INLINE_INSNS_RECURSIVE_AUTO);
   int max_depth = PARAM_VALUE(PARAM_MAX_INLINE_RECURSIVE_DEPTH_AUTO);
   int probability = PARAM_VALUE(PARAM_MIN_INLINE_RECURSIVE_PROBABILITY);
-  fibheap_t heap;
+  idxheap_t heap;
   struct cgraph_edge *e;
   struct cgraph_node *master_clone, *next;
   int depth = 0;
@@ -630,10 +625,10 @@ static bool cgraph_decide_recursive_inlining(struct cgraph_node *node,
   /* Make sure that function is small enough to be considered for inlining.  */
   if (!max_depth || cgraph_estimate_size_after_inlining(1, node, node) >= limit)
     return false;
-  heap = fibheap_new();
+  heap = idxheap_new();
   lookup_recursive_calls(node, node, heap);
-  if (fibheap_empty(heap)) {
-    fibheap_delete(heap);
+  if (idxheap_empty(heap)) {
+    idxheap_delete(heap);
     return false;
   }
 
@@ -650,9 +645,9 @@ static bool cgraph_decide_recursive_inlining(struct cgraph_node *node,
       cgraph_clone_inlined_nodes(e, true, false);
 
   /* Do the inlining and update list of recursive call during process.  */
-  while (!fibheap_empty(heap) && (cgraph_estimate_size_after_inlining(
+  while (!idxheap_empty(heap) && (cgraph_estimate_size_after_inlining(
                                       1, node, master_clone) <= limit)) {
-    struct cgraph_edge *curr = (struct cgraph_edge *)fibheap_extract_min(heap);
+    struct cgraph_edge *curr = (struct cgraph_edge *)idxheap_extract_min(heap);
     struct cgraph_node *cnode;
 
     depth = 1;
@@ -692,10 +687,10 @@ static bool cgraph_decide_recursive_inlining(struct cgraph_node *node,
     lookup_recursive_calls(node, curr->callee, heap);
     n++;
   }
-  if (!fibheap_empty(heap) && dump_file)
+  if (!idxheap_empty(heap) && dump_file)
     fprintf(dump_file, "    Recursive inlining growth limit met.\n");
 
-  fibheap_delete(heap);
+  idxheap_delete(heap);
   if (dump_file)
     fprintf(dump_file,
             "\n   Inlined %i times, body grown from %i to %i insns\n", n,
@@ -742,13 +737,14 @@ static int compute_max_insns(int insns) {
 }
 
 /* Compute badness of all edges in NEW_EDGES and add them to the HEAP.  */
-static void add_new_edges_to_heap(fibheap_t heap,
+static void add_new_edges_to_heap(idxheap_t heap,
                                   VEC(cgraph_edge_p, heap) * new_edges) {
   while (VEC_length(cgraph_edge_p, new_edges) > 0) {
     struct cgraph_edge *edge = VEC_pop(cgraph_edge_p, new_edges);
 
     gcc_assert(!edge->aux);
-    edge->aux = fibheap_insert(heap, cgraph_edge_badness(edge), edge);
+    edge->aux =
+        (void *)(size_t)idxheap_insert(heap, cgraph_edge_badness(edge), edge);
   }
 }
 
@@ -763,7 +759,7 @@ static void cgraph_decide_inlining_of_small_functions(void) {
   struct cgraph_node *node;
   struct cgraph_edge *edge;
   const char *failed_reason;
-  fibheap_t heap = fibheap_new();
+  idxheap_t heap = idxheap_new();
   bitmap updated_nodes = BITMAP_ALLOC(NULL);
   int min_insns, max_insns;
   VEC(cgraph_edge_p, heap) *new_indirect_edges = NULL;
@@ -793,7 +789,8 @@ static void cgraph_decide_inlining_of_small_functions(void) {
     for (edge = node->callers; edge; edge = edge->next_caller)
       if (edge->inline_failed) {
         gcc_assert(!edge->aux);
-        edge->aux = fibheap_insert(heap, cgraph_edge_badness(edge), edge);
+        edge->aux = (void *)(size_t)idxheap_insert(
+            heap, cgraph_edge_badness(edge), edge);
       }
   }
 
@@ -801,7 +798,7 @@ static void cgraph_decide_inlining_of_small_functions(void) {
   min_insns = overall_insns;
 
   while (overall_insns <= max_insns &&
-         (edge = (struct cgraph_edge *)fibheap_extract_min(heap))) {
+         (edge = (struct cgraph_edge *)idxheap_extract_min(heap))) {
     int old_insns = overall_insns;
     struct cgraph_node *where;
     int growth =
@@ -948,7 +945,7 @@ static void cgraph_decide_inlining_of_small_functions(void) {
         fprintf(dump_file, "New minimal insns reached: %i\n", min_insns);
     }
   }
-  while ((edge = (struct cgraph_edge *)fibheap_extract_min(heap)) != NULL) {
+  while ((edge = (struct cgraph_edge *)idxheap_extract_min(heap)) != NULL) {
     gcc_assert(edge->aux);
     edge->aux = NULL;
     if (!edge->callee->local.disregard_inline_limits && edge->inline_failed &&
@@ -959,7 +956,7 @@ static void cgraph_decide_inlining_of_small_functions(void) {
 
   if (new_indirect_edges)
     VEC_free(cgraph_edge_p, heap, new_indirect_edges);
-  fibheap_delete(heap);
+  idxheap_delete(heap);
   BITMAP_FREE(updated_nodes);
 }
 
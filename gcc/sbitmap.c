@@ -63,6 +63,190 @@ void sbitmap_verify_popcount(const_sbitmap a) {
 }
 #endif
 
+/* Operations on the elements of sbitmaps, for SBITMAP_APPLY.  They are
+   applied both to single elements and to vectors of them.  */
+#define SBITMAP_AND(A, B, C) ((A) & (B))
+#define SBITMAP_IOR(A, B, C) ((A) | (B))
+#define SBITMAP_XOR(A, B, C) ((A) ^ (B))
+#define SBITMAP_IOR_AND(A, B, C) ((A) | ((B) & (C)))
+#define SBITMAP_AND_IOR(A, B, C) ((A) & ((B) | (C)))
+#define SBITMAP_IOR_AND_COMPL(A, B, C) ((A) | ((B) & ~(C)))
+
+/* The kernels that apply the operations above, one for each.  */
+enum sbitmap_kernel_index {
+  SBITMAP_AND_KERNEL,
+  SBITMAP_IOR_KERNEL,
+  SBITMAP_XOR_KERNEL,
+  SBITMAP_IOR_AND_KERNEL,
+  SBITMAP_AND_IOR_KERNEL,
+  SBITMAP_IOR_AND_COMPL_KERNEL,
+  SBITMAP_NUM_KERNELS
+};
+
+/* A kernel sets each of the first N elements of DSTP to its operation
+   of the elements at the same position in AP, BP and CP, and returns
+   the bits that changed.  DSTP may be one of the sources.  */
+typedef SBITMAP_ELT_TYPE (*sbitmap_kernel)(unsigned int, sbitmap_ptr,
+                                           const_sbitmap_ptr,
+                                           const_sbitmap_ptr,
+                                           const_sbitmap_ptr);
+
+/* Define the kernel NAME for OP.  It processes as many elements as fit
+   in the vector type VEC at a time, and then the rest one by one.  ATTR
+   gives the target it is compiled for.  */
+#define SBITMAP_VEC_KERNEL(NAME, ATTR, VEC, OP)                            \
+  static SBITMAP_ELT_TYPE ATTR NAME(unsigned int n, sbitmap_ptr dstp,      \
+                                    const_sbitmap_ptr ap,                  \
+                                    const_sbitmap_ptr bp,                  \
+                                    const_sbitmap_ptr cp) {                \
+    SBITMAP_ELT_TYPE changed[sizeof(VEC) / sizeof(SBITMAP_ELT_TYPE)];      \
+    const unsigned int elts = sizeof(VEC) / sizeof(SBITMAP_ELT_TYPE);      \
+    unsigned int i = 0, j;                                                 \
+    VEC vchanged;                                                          \
+                                                                           \
+    memset(&vchanged, 0, sizeof(VEC));                                     \
+    for (; i + elts <= n; i += elts) {                                     \
+      VEC a, b, c, d, r;                                                   \
+                                                                           \
+      memcpy(&a, ap + i, sizeof(VEC));                                     \
+      memcpy(&b, bp + i, sizeof(VEC));                                     \
+      memcpy(&c, cp + i, sizeof(VEC));                                     \
+      memcpy(&d, dstp + i, sizeof(VEC));                                   \
+      r = OP(a, b, c);                                                     \
+      vchanged |= d ^ r;                                                   \
+      memcpy(dstp + i, &r, sizeof(VEC));                                   \
+    }                                                                      \
+    memcpy(changed, &vchanged, sizeof(VEC));                               \
+    for (j = 1; j < elts; j++)                                             \
+      changed[0] |= changed[j];                                            \
+                                                                           \
+    for (; i < n; i++) {                                                   \
+      const SBITMAP_ELT_TYPE r = OP(ap[i], bp[i], cp[i]);                  \
+      changed[0] |= dstp[i] ^ r;                                           \
+      dstp[i] = r;                                                         \
+    }                                                                      \
+    return changed[0];                                                     \
+  }
+
+/* Define the kernels for each operation, with names ending in SUFFIX,
+   and a table of them named sbitmap_SUFFIX_kernels.  */
+#define SBITMAP_VEC_KERNELS(SUFFIX, ATTR, VEC)                             \
+  SBITMAP_VEC_KERNEL(sbitmap_and_##SUFFIX, ATTR, VEC, SBITMAP_AND)         \
+  SBITMAP_VEC_KERNEL(sbitmap_ior_##SUFFIX, ATTR, VEC, SBITMAP_IOR)         \
+  SBITMAP_VEC_KERNEL(sbitmap_xor_##SUFFIX, ATTR, VEC, SBITMAP_XOR)         \
+  SBITMAP_VEC_KERNEL(sbitmap_ior_and_##SUFFIX, ATTR, VEC, SBITMAP_IOR_AND) \
+  SBITMAP_VEC_KERNEL(sbitmap_and_ior_##SUFFIX, ATTR, VEC, SBITMAP_AND_IOR) \
+  SBITMAP_VEC_KERNEL(sbitmap_ior_and_compl_##SUFFIX, ATTR, VEC,            \
+                     SBITMAP_IOR_AND_COMPL)                                \
+  static const sbitmap_kernel sbitmap_##SUFFIX##_kernels[] = {             \
+      sbitmap_and_##SUFFIX,     sbitmap_ior_##SUFFIX,                      \
+      sbitmap_xor_##SUFFIX,     sbitmap_ior_and_##SUFFIX,                  \
+      sbitmap_and_ior_##SUFFIX, sbitmap_ior_and_compl_##SUFFIX};
+
+/* Target attributes of the kernels compiled for any host.  */
+#define SBITMAP_GENERIC_ATTR
+
+/* When GCC builds us, the generic kernels process 16 bytes at a time
+   with its vector extensions.  They become SSE2 instructions on x86-64
+   and plain word operations on hosts without a vector unit.  Other
+   compilers get the same code with single elements as the vectors.  */
+#if GCC_VERSION >= 4001
+typedef SBITMAP_ELT_TYPE sbitmap_vec __attribute__((vector_size(16)));
+#else
+typedef SBITMAP_ELT_TYPE sbitmap_vec;
+#endif
+
+SBITMAP_VEC_KERNELS(generic, SBITMAP_GENERIC_ATTR, sbitmap_vec)
+
+/* Return the number of bits set in the first N elements of AP.  */
+
+static unsigned long sbitmap_count_bits_generic(const_sbitmap_ptr ap,
+                                                unsigned int n) {
+  unsigned long count = 0;
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    count += do_popcount(ap[i]);
+  return count;
+}
+
+#if (GCC_VERSION >= 4004) && (defined(__i386__) || defined(__x86_64__))
+
+/* Kernels for x86 CPUs with SSE2, if the rest of GCC is not compiled
+   for them already, and with AVX, which process 32 bytes at a time.
+   They are only used if the CPU supports them.  */
+
+#ifndef __SSE2__
+SBITMAP_VEC_KERNELS(sse2, __attribute__((__target__("sse2"))), sbitmap_vec)
+#endif
+
+typedef SBITMAP_ELT_TYPE sbitmap_vec_avx __attribute__((vector_size(32)));
+
+SBITMAP_VEC_KERNELS(avx, __attribute__((__target__("avx"))), sbitmap_vec_avx)
+
+/* Count bits with the POPCNT instruction.  */
+
+static unsigned long __attribute__((__target__("popcnt")))
+sbitmap_count_bits_popcnt(const_sbitmap_ptr ap, unsigned int n) {
+  unsigned long count = 0;
+  unsigned int i;
+
+  for (i = 0; i < n; i++)
+    count += do_popcount(ap[i]);
+  return count;
+}
+
+#include "config/i386/cpuid.h"
+
+/* Return the features enabled in extended control register 0, which
+   tell whether the operating system saves the AVX registers.  */
+
+static unsigned int sbitmap_xgetbv0(void) {
+  unsigned int eax, edx;
+
+  /* xgetbv, which older assemblers do not know.  */
+  __asm__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+}
+
+static const sbitmap_kernel *sbitmap_kernels = sbitmap_generic_kernels;
+static unsigned long (*sbitmap_count_bits)(const_sbitmap_ptr, unsigned int) =
+    sbitmap_count_bits_generic;
+
+/* Select the fastest kernels the CPU supports.  */
+
+void init_sbitmap(void) {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return;
+
+#ifndef __SSE2__
+  if (edx & bit_SSE2)
+    sbitmap_kernels = sbitmap_sse2_kernels;
+#endif
+  if ((ecx & (bit_AVX | bit_OSXSAVE)) == (bit_AVX | bit_OSXSAVE) &&
+      (sbitmap_xgetbv0() & 6) == 6)
+    sbitmap_kernels = sbitmap_avx_kernels;
+  if (ecx & bit_POPCNT)
+    sbitmap_count_bits = sbitmap_count_bits_popcnt;
+}
+
+#else
+
+#define sbitmap_kernels sbitmap_generic_kernels
+#define sbitmap_count_bits sbitmap_count_bits_generic
+
+void init_sbitmap(void) {}
+
+#endif
+
+/* Set each of the first N elements of DSTP to OP of the elements at
+   the same position in AP, BP and CP, and OR the bits that change into
+   CHANGED.  DSTP may be one of the sources.  */
+#define SBITMAP_APPLY(N, DSTP, AP, BP, CP, OP, CHANGED)   \
+  ((CHANGED) |= sbitmap_kernels[OP##_KERNEL]((N), (DSTP), (AP), (BP), (CP)))
+
 /* Bitmap manipulation routines.  */
 
 /* Allocate a simple bitmap of N_ELMS bits.  */
@@ -334,36 +518,24 @@ void sbitmap_vector_ones(sbitmap *bmap, unsigned int n_vecs) {
 
 bool sbitmap_union_of_diff_cg(sbitmap dst, const_sbitmap a, const_sbitmap b,
                               const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & ~*cp++);
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_IOR_AND_COMPL, changed);
 
   return changed != 0;
 }
 
 void sbitmap_union_of_diff(sbitmap dst, const_sbitmap a, const_sbitmap b,
                            const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
+  SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount && !a->popcount && !b->popcount && !c->popcount);
 
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ | (*bp++ & ~*cp++);
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_IOR_AND_COMPL, changed);
 }
 
 /* Set bitmap DST to the bitwise negation of the bitmap SRC.  */
@@ -433,19 +605,12 @@ bool sbitmap_any_common_bits(const_sbitmap a, const_sbitmap b) {
    Return nonzero if any change is made.  */
 
 bool sbitmap_a_and_b_cg(sbitmap dst, const_sbitmap a, const_sbitmap b) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ & *bp++;
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, b->elms,
+                SBITMAP_AND, changed);
 
   return changed != 0;
 }
@@ -458,6 +623,13 @@ void sbitmap_a_and_b(sbitmap dst, const_sbitmap a, const_sbitmap b) {
   bool has_popcount = dst->popcount != NULL;
   unsigned char *popcountp = dst->popcount;
 
+  if (!has_popcount) {
+    SBITMAP_ELT_TYPE changed = 0;
+
+    SBITMAP_APPLY(n, dstp, ap, bp, bp, SBITMAP_AND, changed);
+    return;
+  }
+
   for (i = 0; i < n; i++) {
     const SBITMAP_ELT_TYPE tmp = *ap++ & *bp++;
     if (has_popcount) {
@@ -478,19 +650,12 @@ void sbitmap_a_and_b(sbitmap dst, const_sbitmap a, const_sbitmap b) {
    Return nonzero if any change is made.  */
 
 bool sbitmap_a_xor_b_cg(sbitmap dst, const_sbitmap a, const_sbitmap b) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ ^ *bp++;
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, b->elms,
+                SBITMAP_XOR, changed);
 
   return changed != 0;
 }
@@ -503,6 +668,13 @@ void sbitmap_a_xor_b(sbitmap dst, const_sbitmap a, const_sbitmap b) {
   bool has_popcount = dst->popcount != NULL;
   unsigned char *popcountp = dst->popcount;
 
+  if (!has_popcount) {
+    SBITMAP_ELT_TYPE changed = 0;
+
+    SBITMAP_APPLY(n, dstp, ap, bp, bp, SBITMAP_XOR, changed);
+    return;
+  }
+
   for (i = 0; i < n; i++) {
     const SBITMAP_ELT_TYPE tmp = *ap++ ^ *bp++;
     if (has_popcount) {
@@ -523,19 +695,12 @@ void sbitmap_a_xor_b(sbitmap dst, const_sbitmap a, const_sbitmap b) {
    Return nonzero if any change is made.  */
 
 bool sbitmap_a_or_b_cg(sbitmap dst, const_sbitmap a, const_sbitmap b) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ | *bp++;
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, b->elms,
+                SBITMAP_IOR, changed);
 
   return changed != 0;
 }
@@ -548,6 +713,13 @@ void sbitmap_a_or_b(sbitmap dst, const_sbitmap a, const_sbitmap b) {
   bool has_popcount = dst->popcount != NULL;
   unsigned char *popcountp = dst->popcount;
 
+  if (!has_popcount) {
+    SBITMAP_ELT_TYPE changed = 0;
+
+    SBITMAP_APPLY(n, dstp, ap, bp, bp, SBITMAP_IOR, changed);
+    return;
+  }
+
   for (i = 0; i < n; i++) {
     const SBITMAP_ELT_TYPE tmp = *ap++ | *bp++;
     if (has_popcount) {
@@ -582,36 +754,24 @@ bool sbitmap_a_subset_b_p(const_sbitmap a, const_sbitmap b) {
 
 bool sbitmap_a_or_b_and_c_cg(sbitmap dst, const_sbitmap a, const_sbitmap b,
                              const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & *cp++);
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_IOR_AND, changed);
 
   return changed != 0;
 }
 
 void sbitmap_a_or_b_and_c(sbitmap dst, const_sbitmap a, const_sbitmap b,
                           const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
+  SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ | (*bp++ & *cp++);
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_IOR_AND, changed);
 }
 
 /* Set DST to be (A and (B or C)).
@@ -619,34 +779,22 @@ void sbitmap_a_or_b_and_c(sbitmap dst, const_sbitmap a, const_sbitmap b,
 
 bool sbitmap_a_and_b_or_c_cg(sbitmap dst, const_sbitmap a, const_sbitmap b,
                              const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
   SBITMAP_ELT_TYPE changed = 0;
 
   gcc_assert(!dst->popcount);
 
-  for (i = 0; i < n; i++) {
-    const SBITMAP_ELT_TYPE tmp = *ap++ & (*bp++ | *cp++);
-    changed |= *dstp ^ tmp;
-    *dstp++ = tmp;
-  }
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_AND_IOR, changed);
 
   return changed != 0;
 }
 
 void sbitmap_a_and_b_or_c(sbitmap dst, const_sbitmap a, const_sbitmap b,
                           const_sbitmap c) {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  const_sbitmap_ptr ap = a->elms;
-  const_sbitmap_ptr bp = b->elms;
-  const_sbitmap_ptr cp = c->elms;
+  SBITMAP_ELT_TYPE changed = 0;
 
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ & (*bp++ | *cp++);
+  SBITMAP_APPLY(dst->size, dst->elms, a->elms, b->elms, c->elms,
+                SBITMAP_AND_IOR, changed);
 }
 
 #ifdef IN_GCC
@@ -674,7 +822,7 @@ void sbitmap_intersection_of_succs(sbitmap dst, sbitmap *src, int bb) {
     sbitmap_ones(dst);
   else
     for (++ix; ix < EDGE_COUNT(b->succs); ix++) {
-      unsigned int i;
+      SBITMAP_ELT_TYPE changed = 0;
       sbitmap_ptr p, r;
 
       e = EDGE_SUCC(b, ix);
@@ -683,8 +831,7 @@ void sbitmap_intersection_of_succs(sbitmap dst, sbitmap *src, int bb) {
 
       p = src[e->dest->index]->elms;
       r = dst->elms;
-      for (i = 0; i < set_size; i++)
-        *r++ &= *p++;
+      SBITMAP_APPLY(set_size, r, r, p, p, SBITMAP_AND, changed);
     }
 }
 
@@ -712,7 +859,7 @@ void sbitmap_intersection_of_preds(sbitmap dst, sbitmap *src, int bb) {
     sbitmap_ones(dst);
   else
     for (++ix; ix < EDGE_COUNT(b->preds); ix++) {
-      unsigned int i;
+      SBITMAP_ELT_TYPE changed = 0;
       sbitmap_ptr p, r;
 
       e = EDGE_PRED(b, ix);
@@ -721,8 +868,7 @@ void sbitmap_intersection_of_preds(sbitmap dst, sbitmap *src, int bb) {
 
       p = src[e->src->index]->elms;
       r = dst->elms;
-      for (i = 0; i < set_size; i++)
-        *r++ &= *p++;
+      SBITMAP_APPLY(set_size, r, r, p, p, SBITMAP_AND, changed);
     }
 }
 
@@ -750,7 +896,7 @@ void sbitmap_union_of_succs(sbitmap dst, sbitmap *src, int bb) {
     sbitmap_zero(dst);
   else
     for (ix++; ix < EDGE_COUNT(b->succs); ix++) {
-      unsigned int i;
+      SBITMAP_ELT_TYPE changed = 0;
       sbitmap_ptr p, r;
 
       e = EDGE_SUCC(b, ix);
@@ -759,8 +905,7 @@ void sbitmap_union_of_succs(sbitmap dst, sbitmap *src, int bb) {
 
       p = src[e->dest->index]->elms;
       r = dst->elms;
-      for (i = 0; i < set_size; i++)
-        *r++ |= *p++;
+      SBITMAP_APPLY(set_size, r, r, p, p, SBITMAP_IOR, changed);
     }
 }
 
@@ -788,7 +933,7 @@ void sbitmap_union_of_preds(sbitmap dst, sbitmap *src, int bb) {
     sbitmap_zero(dst);
   else
     for (ix++; ix < EDGE_COUNT(b->preds); ix++) {
-      unsigned int i;
+      SBITMAP_ELT_TYPE changed = 0;
       sbitmap_ptr p, r;
 
       e = EDGE_PRED(b, ix);
@@ -797,8 +942,7 @@ void sbitmap_union_of_preds(sbitmap dst, sbitmap *src, int bb) {
 
       p = src[e->src->index]->elms;
       r = dst->elms;
-      for (i = 0; i < set_size; i++)
-        *r++ |= *p++;
+      SBITMAP_APPLY(set_size, r, r, p, p, SBITMAP_IOR, changed);
     }
 }
 #endif
@@ -940,15 +1084,15 @@ unsigned long sbitmap_popcount(const_sbitmap a, unsigned long maxbit) {
 
   /* Count the bits in the full word.  */
   lastword = MIN(a->size, SBITMAP_SET_SIZE(maxbit + 1) - 1);
-  for (ix = 0; ix < lastword; ix++) {
-    if (a->popcount) {
+  if (a->popcount)
+    for (ix = 0; ix < lastword; ix++) {
       count += a->popcount[ix];
 #ifdef BITMAP_DEBUGGING
       gcc_assert(a->popcount[ix] == do_popcount(a->elms[ix]));
 #endif
-    } else
-      count += do_popcount(a->elms[ix]);
-  }
+    }
+  else
+    count = sbitmap_count_bits(a->elms, lastword);
 
   /* Count the remaining bits.  */
   if (lastword < a->size) {
@@ -192,6 +192,7 @@ extern void dump_sbitmap(FILE *, const_sbitmap);
 extern void dump_sbitmap_file(FILE *, const_sbitmap);
 extern void dump_sbitmap_vector(FILE *, const char *, const char *, sbitmap *,
                                 int);
+extern void init_sbitmap(void);
 extern sbitmap sbitmap_alloc(unsigned int);
 extern sbitmap sbitmap_alloc_with_popcount(unsigned int);
 extern sbitmap *sbitmap_vector_alloc(unsigned int, unsigned int);
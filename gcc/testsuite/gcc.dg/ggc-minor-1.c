@@ -0,0 +1,69 @@
+/* Collect at every opportunity, mostly with minor collections, while
+   declarations made early on are completed and used later.  */
+/* { dg-do run } */
+/* { dg-options "-O2 --param ggc-minor-collections=3 --param ggc-min-expand=0 --param ggc-min-heapsize=0" } */
+
+extern void abort (void);
+
+struct node;
+static struct node *make (int, struct node *);
+static int sum (const struct node *);
+
+struct node
+{
+  int value;
+  struct node *next;
+  const char *name;
+};
+
+static struct node pool[16];
+static int used;
+
+static const char *const names[] = { "zero", "one", "two", "three" };
+
+static struct node *
+make (int value, struct node *next)
+{
+  struct node *n = &pool[used++];
+
+  n->value = value;
+  n->next = next;
+  n->name = names[value % 4];
+  return n;
+}
+
+static int
+sum (const struct node *n)
+{
+  int s = 0;
+
+  for (; n; n = n->next)
+    s += n->value + (n->name[0] == 't');
+  return s;
+}
+
+static inline int
+square (int x)
+{
+  return x * x;
+}
+
+static int
+build (int count)
+{
+  struct node *list = 0;
+  int i;
+
+  for (i = 0; i < count; i++)
+    list = make (square (i), list);
+  return sum (list);
+}
+
+int
+main (void)
+{
+  /* The squares are all 0 or 1 modulo 4, so no name starts with 't'.  */
+  if (build (6) != 0 + 1 + 4 + 9 + 16 + 25)
+    abort ();
+  return 0;
+}
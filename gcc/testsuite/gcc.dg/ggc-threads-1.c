@@ -0,0 +1,77 @@
+/* Collect at every opportunity, marking the roots with several
+   threads, while types, tables and functions declared early on are
+   used later.  */
+/* { dg-do run } */
+/* { dg-options "-O2 --param ggc-mark-threads=4 --param ggc-min-expand=0 --param ggc-min-heapsize=0" } */
+
+extern void abort (void);
+
+enum color { RED, GREEN, BLUE, N_COLORS };
+
+struct shape;
+static int area (const struct shape *);
+
+struct shape
+{
+  enum color color;
+  int width, height;
+  const struct shape *inner;
+};
+
+static const char *const color_names[N_COLORS] = { "red", "green", "blue" };
+
+static const struct shape core = { BLUE, 1, 2, 0 };
+static const struct shape middle = { GREEN, 3, 4, &core };
+static const struct shape outer = { RED, 5, 6, &middle };
+
+static int
+area (const struct shape *s)
+{
+  int a = 0;
+
+  for (; s; s = s->inner)
+    a += s->width * s->height;
+  return a;
+}
+
+static inline int
+name_length (enum color c)
+{
+  const char *p = color_names[c];
+  int n = 0;
+
+  while (p[n])
+    n++;
+  return n;
+}
+
+static int
+weigh (const struct shape *s)
+{
+  int w = 0;
+
+  for (; s; s = s->inner)
+    switch (s->color)
+      {
+      case RED:
+	w += 1 + name_length (s->color);
+	break;
+      case GREEN:
+	w += 10 + name_length (s->color);
+	break;
+      default:
+	w += 100 + name_length (s->color);
+	break;
+      }
+  return w;
+}
+
+int
+main (void)
+{
+  if (area (&outer) != 30 + 12 + 2)
+    abort ();
+  if (weigh (&outer) != 1 + 3 + 10 + 5 + 100 + 4)
+    abort ();
+  return 0;
+}
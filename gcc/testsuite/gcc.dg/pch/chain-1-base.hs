@@ -0,0 +1,26 @@
+/* The base of a chained PCH.  */
+
+#define COUNT(a) (sizeof (a) / sizeof ((a)[0]))
+
+enum shape { circle, square = 4, triangle };
+
+/* Completed by the layer, which changes this type in the base.  */
+struct extra;
+
+struct base
+{
+  const char *name;
+  enum shape shape;
+  struct base *next;
+  struct extra *extra;
+};
+
+extern struct base bases[];
+
+static const char *const base_names[] = { "one", "two", "three" };
+
+static inline int
+base_area (const struct base *b)
+{
+  return b->shape * 2;
+}
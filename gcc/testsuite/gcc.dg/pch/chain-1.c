@@ -0,0 +1,25 @@
+/* A PCH layered over another one must compile as the headers do.  */
+
+#include "chain-1.h"
+
+static struct extra extras[] = { { 1, "a" }, { 2, "b" } };
+
+struct base bases[] = {
+  { "one", circle, &bases[1], &extras[0] },
+  { "two", triangle, 0, &extras[1] }
+};
+
+struct layer layers[] = {
+  { &bases[0], SCALE },
+  { &bases[1], SCALE + 1 }
+};
+
+int
+total (void)
+{
+  int i, t = 0;
+
+  for (i = 0; i < (int) COUNT (layers); i++)
+    t += layer_area (&layers[i]) + (layers[i].base->name == base_names[i]);
+  return t;
+}
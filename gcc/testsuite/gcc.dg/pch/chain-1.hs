@@ -0,0 +1,25 @@
+/* A layer over chain-1-base.h, precompiled with -fpch-chain.  */
+
+#include "chain-1-base.h"
+
+#define SCALE 5
+
+struct extra
+{
+  int weight;
+  const char *label;
+};
+
+struct layer
+{
+  struct base *base;
+  int scale;
+};
+
+extern struct layer layers[];
+
+static inline int
+layer_area (const struct layer *l)
+{
+  return base_area (l->base) * l->scale + l->base->extra->weight;
+}
@@ -0,0 +1,19 @@
+/* { dg-options "-I. -Winvalid-pch --param pch-relocate=1" } */
+
+#include "reloc-1.h"
+
+node_t nodes[] = {
+  { "alpha", red, &nodes[1] },
+  { "beta", green, &nodes[2] },
+  { "gamma", blue, 0 }
+};
+
+int
+count_nodes (const node_t *n)
+{
+  int i = 0;
+
+  for (; n; n = n->next)
+    i += twice (n->color) + (n->name == names[i % COUNT (names)]);
+  return i;
+}
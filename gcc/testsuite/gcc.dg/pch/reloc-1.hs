@@ -0,0 +1,27 @@
+/* Identifiers, strings and trees that point at each other, all of
+   which must survive the image being moved.  */
+
+#define COUNT(a) (sizeof (a) / sizeof ((a)[0]))
+
+enum color { red, green = 10, blue };
+
+struct node
+{
+  const char *name;
+  enum color color;
+  struct node *next;
+};
+
+typedef struct node node_t;
+
+extern node_t nodes[];
+
+static const char *const names[] = { "alpha", "beta", "gamma" };
+
+static inline int
+twice (int x)
+{
+  return x + x;
+}
+
+int count_nodes (const node_t *);
@@ -1454,6 +1454,7 @@ static void general_init(const char *argv0) {
   linemap_init(line_table);
   line_table->reallocator = realloc_for_line_map;
   init_ttree();
+  init_sbitmap();
 
   /* Initialize register usage now so switches may override.  */
   init_reg_sets();
@@ -123,6 +123,35 @@ static inline void *next_htab_element(htab_iterator *hti) {
   return NULL;
 }
 
+/* Initialize the grouptab iterator GTI to point to the first element of
+   TABLE, and return that element, or NULL if TABLE is empty.  Empty and
+   deleted slots of a grouptab are null.  */
+
+static inline void *first_grouptab_element(grouptab_iterator *gti,
+                                           grouptab_t table) {
+  gti->slot = table->entries;
+  gti->limit = gti->slot + grouptab_size(table);
+  while (gti->slot < gti->limit && !*gti->slot)
+    ++gti->slot;
+
+  return gti->slot < gti->limit ? *gti->slot : NULL;
+}
+
+/* Return true if the grouptab iterator GTI has reached the end.  */
+
+static inline bool end_grouptab_p(const grouptab_iterator *gti) {
+  return gti->slot >= gti->limit;
+}
+
+/* Advance the grouptab iterator GTI to the next element, and return it.  */
+
+static inline void *next_grouptab_element(grouptab_iterator *gti) {
+  while (++gti->slot < gti->limit)
+    if (*gti->slot)
+      return *gti->slot;
+  return NULL;
+}
+
 /* Initialize ITER to point to the first referenced variable in the
    referenced_vars hashtable, and return that variable.  */
 
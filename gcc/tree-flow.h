@@ -26,6 +26,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "hard-reg-set.h"
 #include "basic-block.h"
 #include "hashtab.h"
+#include "grouptab.h"
 #include "gimple.h"
 #include "tree-ssa-operands.h"
 #include "cgraph.h"
@@ -212,6 +213,17 @@ typedef struct {
   for (RESULT = (TYPE)first_htab_element(&(ITER), (HTAB)); \
        !end_htab_p(&(ITER)); RESULT = (TYPE)next_htab_element(&(ITER)))
 
+typedef struct {
+  void **slot;
+  void **limit;
+} grouptab_iterator;
+
+/* Likewise for the elements of grouptab TAB.  */
+#define FOR_EACH_GROUPTAB_ELEMENT(TAB, RESULT, TYPE, ITER)         \
+  for (RESULT = (TYPE)first_grouptab_element(&(ITER), (TAB));      \
+       !end_grouptab_p(&(ITER));                                   \
+       RESULT = (TYPE)next_grouptab_element(&(ITER)))
+
 /*---------------------------------------------------------------------------
                       Attributes for SSA_NAMEs.
 
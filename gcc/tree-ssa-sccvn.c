@@ -34,6 +34,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "timevar.h"
 #include "fibheap.h"
 #include "hashtab.h"
+#include "grouptab.h"
 #include "tree-iterator.h"
 #include "real.h"
 #include "alloc-pool.h"
@@ -106,15 +107,15 @@ along with GCC; see the file COPYING3.  If not see
 /* The set of hashtables and alloc_pool's for their items.  */
 
 typedef struct vn_tables_s {
-  htab_t nary;
-  htab_t phis;
-  htab_t references;
+  grouptab_t nary;
+  grouptab_t phis;
+  grouptab_t references;
   struct obstack nary_obstack;
   alloc_pool phis_pool;
   alloc_pool references_pool;
 } *vn_tables_t;
 
-static htab_t constant_to_value_id;
+static grouptab_t constant_to_value_id;
 static bitmap constant_value_ids;
 
 /* Valid hashtables storing information we have proven to be
@@ -314,8 +315,8 @@ unsigned int get_constant_value_id(tree constant) {
 
   vc.hashcode = vn_hash_constant_with_type(constant);
   vc.constant = constant;
-  slot = htab_find_slot_with_hash(constant_to_value_id, &vc, vc.hashcode,
-                                  NO_INSERT);
+  slot = grouptab_find_slot_with_hash(constant_to_value_id, &vc, vc.hashcode,
+                                      NO_INSERT);
   if (slot)
     return ((vn_constant_t)*slot)->value_id;
   return 0;
@@ -330,8 +331,8 @@ unsigned int get_or_alloc_constant_value_id(tree constant) {
 
   vc->hashcode = vn_hash_constant_with_type(constant);
   vc->constant = constant;
-  slot =
-      htab_find_slot_with_hash(constant_to_value_id, vc, vc->hashcode, INSERT);
+  slot = grouptab_find_slot_with_hash(constant_to_value_id, vc, vc->hashcode,
+                                      INSERT);
   if (*slot) {
     free(vc);
     return ((vn_constant_t)*slot)->value_id;
@@ -872,11 +873,11 @@ static tree vn_reference_lookup_1(vn_reference_t vr, vn_reference_t *vnresult) {
   hashval_t hash;
 
   hash = vr->hashcode;
-  slot =
-      htab_find_slot_with_hash(current_info->references, vr, hash, NO_INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->references, vr, hash,
+                                      NO_INSERT);
   if (!slot && current_info == optimistic_info)
-    slot =
-        htab_find_slot_with_hash(valid_info->references, vr, hash, NO_INSERT);
+    slot = grouptab_find_slot_with_hash(valid_info->references, vr, hash,
+                                        NO_INSERT);
   if (slot) {
     if (vnresult)
       *vnresult = (vn_reference_t)*slot;
@@ -976,8 +977,8 @@ vn_reference_t vn_reference_insert(tree op, tree result,
   vr1->hashcode = vn_reference_compute_hash(vr1);
   vr1->result = TREE_CODE(result) == SSA_NAME ? SSA_VAL(result) : result;
 
-  slot = htab_find_slot_with_hash(current_info->references, vr1, vr1->hashcode,
-                                  INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->references, vr1,
+                                      vr1->hashcode, INSERT);
 
   /* Because we lookup stores using vuses, and value number failures
      using the vdefs (see visit_reference_op_store for how and why),
@@ -1017,8 +1018,8 @@ vn_reference_t vn_reference_insert_pieces(VEC(tree, gc) * vuses,
     result = SSA_VAL(result);
   vr1->result = result;
 
-  slot = htab_find_slot_with_hash(current_info->references, vr1, vr1->hashcode,
-                                  INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->references, vr1,
+                                      vr1->hashcode, INSERT);
 
   /* At this point we should have all the things inserted that we have
   seen before, and we should never try inserting something that
@@ -1104,11 +1105,11 @@ tree vn_nary_op_lookup_pieces(unsigned int length, enum tree_code code,
   vno1.op[2] = op2;
   vno1.op[3] = op3;
   vno1.hashcode = vn_nary_op_compute_hash(&vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
-                                  NO_INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
+                                      NO_INSERT);
   if (!slot && current_info == optimistic_info)
-    slot = htab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
-                                    NO_INSERT);
+    slot = grouptab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
+                                        NO_INSERT);
   if (!slot)
     return NULL_TREE;
   if (vnresult)
@@ -1135,11 +1136,11 @@ tree vn_nary_op_lookup(tree op, vn_nary_op_t *vnresult) {
   for (i = 0; i < vno1.length; ++i)
     vno1.op[i] = TREE_OPERAND(op, i);
   vno1.hashcode = vn_nary_op_compute_hash(&vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
-                                  NO_INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
+                                      NO_INSERT);
   if (!slot && current_info == optimistic_info)
-    slot = htab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
-                                    NO_INSERT);
+    slot = grouptab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
+                                        NO_INSERT);
   if (!slot)
     return NULL_TREE;
   if (vnresult)
@@ -1168,11 +1169,11 @@ tree vn_nary_op_lookup_stmt(gimple stmt, vn_nary_op_t *vnresult) {
       vno1.opcode == VIEW_CONVERT_EXPR)
     vno1.op[0] = TREE_OPERAND(vno1.op[0], 0);
   vno1.hashcode = vn_nary_op_compute_hash(&vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
-                                  NO_INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, &vno1, vno1.hashcode,
+                                      NO_INSERT);
   if (!slot && current_info == optimistic_info)
-    slot = htab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
-                                    NO_INSERT);
+    slot = grouptab_find_slot_with_hash(valid_info->nary, &vno1, vno1.hashcode,
+                                        NO_INSERT);
   if (!slot)
     return NULL_TREE;
   if (vnresult)
@@ -1208,8 +1209,8 @@ vn_nary_op_t vn_nary_op_insert_pieces(unsigned int length, enum tree_code code,
     vno1->op[3] = op3;
   vno1->result = result;
   vno1->hashcode = vn_nary_op_compute_hash(vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
-                                  INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
+                                      INSERT);
   gcc_assert(!*slot);
 
   *slot = vno1;
@@ -1237,8 +1238,8 @@ vn_nary_op_t vn_nary_op_insert(tree op, tree result) {
     vno1->op[i] = TREE_OPERAND(op, i);
   vno1->result = result;
   vno1->hashcode = vn_nary_op_compute_hash(vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
-                                  INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
+                                      INSERT);
   gcc_assert(!*slot);
 
   *slot = vno1;
@@ -1268,8 +1269,8 @@ vn_nary_op_t vn_nary_op_insert_stmt(gimple stmt, tree result) {
     vno1->op[0] = TREE_OPERAND(vno1->op[0], 0);
   vno1->result = result;
   vno1->hashcode = vn_nary_op_compute_hash(vno1);
-  slot = htab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
-                                  INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->nary, vno1, vno1->hashcode,
+                                      INSERT);
   gcc_assert(!*slot);
 
   *slot = vno1;
@@ -1364,11 +1365,11 @@ static tree vn_phi_lookup(gimple phi) {
   vp1.phiargs = shared_lookup_phiargs;
   vp1.block = gimple_bb(phi);
   vp1.hashcode = vn_phi_compute_hash(&vp1);
-  slot = htab_find_slot_with_hash(current_info->phis, &vp1, vp1.hashcode,
-                                  NO_INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->phis, &vp1, vp1.hashcode,
+                                      NO_INSERT);
   if (!slot && current_info == optimistic_info)
-    slot = htab_find_slot_with_hash(valid_info->phis, &vp1, vp1.hashcode,
-                                    NO_INSERT);
+    slot = grouptab_find_slot_with_hash(valid_info->phis, &vp1, vp1.hashcode,
+                                        NO_INSERT);
   if (!slot)
     return NULL_TREE;
   return ((vn_phi_t)*slot)->result;
@@ -1395,8 +1396,8 @@ static vn_phi_t vn_phi_insert(gimple phi, tree result) {
   vp1->result = result;
   vp1->hashcode = vn_phi_compute_hash(vp1);
 
-  slot =
-      htab_find_slot_with_hash(current_info->phis, vp1, vp1->hashcode, INSERT);
+  slot = grouptab_find_slot_with_hash(current_info->phis, vp1, vp1->hashcode,
+                                      INSERT);
 
   /* Because we iterate over phi operations more than once, it's
      possible the slot might already exist here, hence no assert.*/
@@ -1406,7 +1407,7 @@ static vn_phi_t vn_phi_insert(gimple phi, tree result) {
 
 /* Print set of components in strongly connected component SCC to OUT. */
 
-static void print_scc(FILE *out, VEC(tree, heap) * scc) {
+static void print_scc(FILE *out, VEC(tree, stack) * scc) {
   tree var;
   unsigned int i;
 
@@ -1550,8 +1551,8 @@ static bool visit_reference_op_call(tree lhs, gimple stmt) {
     vr2->operands = valueize_refs(create_reference_ops_from_call(stmt));
     vr2->hashcode = vr1.hashcode;
     vr2->result = lhs;
-    slot = htab_find_slot_with_hash(current_info->references, vr2,
-                                    vr2->hashcode, INSERT);
+    slot = grouptab_find_slot_with_hash(current_info->references, vr2,
+                                        vr2->hashcode, INSERT);
     if (*slot)
       free_reference(*slot);
     *slot = vr2;
@@ -2234,14 +2235,14 @@ static int compare_ops(const void *pa, const void *pb) {
    This means that when the sort is complete, iterating through the
    array will give you the members in RPO order.  */
 
-static void sort_scc(VEC(tree, heap) * scc) {
+static void sort_scc(VEC(tree, stack) * scc) {
   qsort(VEC_address(tree, scc), VEC_length(tree, scc), sizeof(tree),
         compare_ops);
 }
 
 /* Process a strongly connected component in the SSA graph.  */
 
-static void process_scc(VEC(tree, heap) * scc) {
+static void process_scc(VEC(tree, stack) * scc) {
   /* If the SCC has a single member, just visit it.  */
 
   if (VEC_length(tree, scc) == 1) {
@@ -2263,9 +2264,9 @@ static void process_scc(VEC(tree, heap) * scc) {
       /* As we are value-numbering optimistically we have to
          clear the expression tables and the simplified expressions
          in each iteration until we converge.  */
-      htab_empty(optimistic_info->nary);
-      htab_empty(optimistic_info->phis);
-      htab_empty(optimistic_info->references);
+      grouptab_empty(optimistic_info->nary);
+      grouptab_empty(optimistic_info->phis);
+      grouptab_empty(optimistic_info->references);
       obstack_free(&optimistic_info->nary_obstack, NULL);
       gcc_obstack_init(&optimistic_info->nary_obstack);
       empty_alloc_pool(optimistic_info->phis_pool);
@@ -2293,7 +2294,8 @@ DEF_VEC_ALLOC_O(ssa_op_iter, heap);
    we run into resource limits.  */
 
 static bool extract_and_process_scc_for_name(tree name) {
-  VEC(tree, heap) *scc = NULL;
+  /* Most SCCs are a single name.  */
+  VEC(tree, stack) *scc = VEC_stack_alloc(tree, 16);
   tree x;
 
   /* Found an SCC, pop the components off the SCC stack and
@@ -2302,7 +2304,7 @@ static bool extract_and_process_scc_for_name(tree name) {
     x = VEC_pop(tree, sccstack);
 
     VN_INFO(x)->on_sccstack = false;
-    VEC_safe_push(tree, heap, scc, x);
+    VEC_safe_push(tree, stack, scc, x);
   } while (x != name);
 
   /* Bail out of SCCVN in case a SCC turns out to be incredibly large.  */
@@ -2313,6 +2315,7 @@ static bool extract_and_process_scc_for_name(tree name) {
               "SCC size %u exceeding %u\n",
               VEC_length(tree, scc),
               (unsigned)PARAM_VALUE(PARAM_SCCVN_MAX_SCC_SIZE));
+    VEC_free(tree, stack, scc);
     return false;
   }
 
@@ -2324,7 +2327,7 @@ static bool extract_and_process_scc_for_name(tree name) {
 
   process_scc(scc);
 
-  VEC_free(tree, heap, scc);
+  VEC_free(tree, stack, scc);
 
   return true;
 }
@@ -2420,10 +2423,10 @@ start_over:
 /* Allocate a value number table.  */
 
 static void allocate_vn_table(vn_tables_t table) {
-  table->phis = htab_create(23, vn_phi_hash, vn_phi_eq, free_phi);
-  table->nary = htab_create(23, vn_nary_op_hash, vn_nary_op_eq, NULL);
+  table->phis = grouptab_create(23, vn_phi_hash, vn_phi_eq, free_phi);
+  table->nary = grouptab_create(23, vn_nary_op_hash, vn_nary_op_eq, NULL);
   table->references =
-      htab_create(23, vn_reference_hash, vn_reference_eq, free_reference);
+      grouptab_create(23, vn_reference_hash, vn_reference_eq, free_reference);
 
   gcc_obstack_init(&table->nary_obstack);
   table->phis_pool = create_alloc_pool("VN phis", sizeof(struct vn_phi_s), 30);
@@ -2434,9 +2437,9 @@ static void allocate_vn_table(vn_tables_t table) {
 /* Free a value number table.  */
 
 static void free_vn_table(vn_tables_t table) {
-  htab_delete(table->phis);
-  htab_delete(table->nary);
-  htab_delete(table->references);
+  grouptab_delete(table->phis);
+  grouptab_delete(table->nary);
+  grouptab_delete(table->references);
   obstack_free(&table->nary_obstack, NULL);
   free_alloc_pool(table->phis_pool);
   free_alloc_pool(table->references_pool);
@@ -2450,7 +2453,7 @@ static void init_scc_vn(void) {
   calculate_dominance_info(CDI_DOMINATORS);
   sccstack = NULL;
   constant_to_value_id =
-      htab_create(23, vn_constant_hash, vn_constant_eq, free);
+      grouptab_create(23, vn_constant_hash, vn_constant_eq, free);
 
   constant_value_ids = BITMAP_ALLOC(NULL);
 
@@ -2504,7 +2507,7 @@ static void init_scc_vn(void) {
 void free_scc_vn(void) {
   size_t i;
 
-  htab_delete(constant_to_value_id);
+  grouptab_delete(constant_to_value_id);
   BITMAP_FREE(constant_value_ids);
   VEC_free(tree, heap, shared_lookup_phiargs);
   VEC_free(tree, gc, shared_lookup_vops);
@@ -2529,7 +2532,7 @@ void free_scc_vn(void) {
 /* Set the value ids in the valid hash tables.  */
 
 static void set_hashtable_value_ids(void) {
-  htab_iterator hi;
+  grouptab_iterator hi;
   vn_nary_op_t vno;
   vn_reference_t vr;
   vn_phi_t vp;
@@ -2537,7 +2540,7 @@ static void set_hashtable_value_ids(void) {
   /* Now set the value ids of the things we had put in the hash
      table.  */
 
-  FOR_EACH_HTAB_ELEMENT(valid_info->nary, vno, vn_nary_op_t, hi) {
+  FOR_EACH_GROUPTAB_ELEMENT(valid_info->nary, vno, vn_nary_op_t, hi) {
     if (vno->result) {
       if (TREE_CODE(vno->result) == SSA_NAME)
         vno->value_id = VN_INFO(vno->result)->value_id;
@@ -2546,7 +2549,7 @@ static void set_hashtable_value_ids(void) {
     }
   }
 
-  FOR_EACH_HTAB_ELEMENT(valid_info->phis, vp, vn_phi_t, hi) {
+  FOR_EACH_GROUPTAB_ELEMENT(valid_info->phis, vp, vn_phi_t, hi) {
     if (vp->result) {
       if (TREE_CODE(vp->result) == SSA_NAME)
         vp->value_id = VN_INFO(vp->result)->value_id;
@@ -2555,7 +2558,7 @@ static void set_hashtable_value_ids(void) {
     }
   }
 
-  FOR_EACH_HTAB_ELEMENT(valid_info->references, vr, vn_reference_t, hi) {
+  FOR_EACH_GROUPTAB_ELEMENT(valid_info->references, vr, vn_reference_t, hi) {
     if (vr->result) {
       if (TREE_CODE(vr->result) == SSA_NAME)
         vr->value_id = VN_INFO(vr->result)->value_id;
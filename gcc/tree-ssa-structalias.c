@@ -418,10 +418,10 @@ struct constraint_expr {
 
 typedef struct constraint_expr ce_s;
 DEF_VEC_O(ce_s);
-DEF_VEC_ALLOC_O(ce_s, heap);
-static void get_constraint_for_1(tree, VEC(ce_s, heap) **, bool);
-static void get_constraint_for(tree, VEC(ce_s, heap) **);
-static void do_deref(VEC(ce_s, heap) **);
+DEF_VEC_ALLOC_O_STACK(ce_s);
+static void get_constraint_for_1(tree, VEC(ce_s, stack) **, bool);
+static void get_constraint_for(tree, VEC(ce_s, stack) **);
+static void do_deref(VEC(ce_s, stack) **);
 
 /* Our set constraints are made up of two constraint expressions, one
    LHS, and one RHS.
@@ -2338,7 +2338,7 @@ static struct constraint_expr get_constraint_exp_for_temp(tree t) {
 /* Get a constraint expression vector from an SSA_VAR_P node.
    If address_p is true, the result will be taken its address of.  */
 
-static void get_constraint_for_ssa_var(tree t, VEC(ce_s, heap) * *results,
+static void get_constraint_for_ssa_var(tree t, VEC(ce_s, stack) * *results,
                                        bool address_p) {
   struct constraint_expr cexpr;
   varinfo_t vi;
@@ -2371,12 +2371,12 @@ static void get_constraint_for_ssa_var(tree t, VEC(ce_s, heap) * *results,
   if (!address_p) {
     for (; vi; vi = vi->next) {
       cexpr.var = vi->id;
-      VEC_safe_push(ce_s, heap, *results, &cexpr);
+      VEC_safe_push(ce_s, stack, *results, &cexpr);
     }
     return;
   }
 
-  VEC_safe_push(ce_s, heap, *results, &cexpr);
+  VEC_safe_push(ce_s, stack, *results, &cexpr);
 }
 
 /* Process constraint T, performing various simplifications and then
@@ -2461,7 +2461,7 @@ static HOST_WIDE_INT bitpos_of_field(const tree fdecl) {
    resulting constraint expressions in *RESULTS.  */
 
 static void get_constraint_for_ptr_offset(tree ptr, tree offset,
-                                          VEC(ce_s, heap) * *results) {
+                                          VEC(ce_s, stack) * *results) {
   struct constraint_expr *c;
   unsigned int j, n;
   unsigned HOST_WIDE_INT rhsunitoffset, rhsoffset;
@@ -2484,7 +2484,7 @@ static void get_constraint_for_ptr_offset(tree ptr, tree offset,
     temp.var = anything_id;
     temp.type = SCALAR;
     temp.offset = 0;
-    VEC_safe_push(ce_s, heap, *results, &temp);
+    VEC_safe_push(ce_s, stack, *results, &temp);
     return;
   }
 
@@ -2496,7 +2496,7 @@ static void get_constraint_for_ptr_offset(tree ptr, tree offset,
     temp.var = anything_id;
     temp.type = SCALAR;
     temp.offset = 0;
-    VEC_safe_push(ce_s, heap, *results, &temp);
+    VEC_safe_push(ce_s, stack, *results, &temp);
     return;
   }
 
@@ -2544,7 +2544,7 @@ static void get_constraint_for_ptr_offset(tree ptr, tree offset,
         c2.var = temp->next->id;
         c2.type = ADDRESSOF;
         c2.offset = 0;
-        VEC_safe_push(ce_s, heap, *results, &c2);
+        VEC_safe_push(ce_s, stack, *results, &c2);
       }
       c->var = temp->id;
       c->offset = 0;
@@ -2560,7 +2560,7 @@ static void get_constraint_for_ptr_offset(tree ptr, tree offset,
 /* Given a COMPONENT_REF T, return the constraint_expr vector for it.
    If address_p is true the result will be taken its address of.  */
 
-static void get_constraint_for_component_ref(tree t, VEC(ce_s, heap) * *results,
+static void get_constraint_for_component_ref(tree t, VEC(ce_s, stack) * *results,
                                              bool address_p) {
   tree orig_t = t;
   HOST_WIDE_INT bitsize = -1;
@@ -2581,7 +2581,7 @@ static void get_constraint_for_component_ref(tree t, VEC(ce_s, heap) * *results,
     temp.offset = 0;
     temp.var = integer_id;
     temp.type = SCALAR;
-    VEC_safe_push(ce_s, heap, *results, &temp);
+    VEC_safe_push(ce_s, stack, *results, &temp);
     return;
   }
 
@@ -2619,7 +2619,7 @@ static void get_constraint_for_component_ref(tree t, VEC(ce_s, heap) * *results,
       for (curr = get_varinfo(cexpr.var); curr; curr = curr->next) {
         if (ranges_overlap_p(curr->offset, curr->size, bitpos, bitmaxsize)) {
           cexpr.var = curr->id;
-          VEC_safe_push(ce_s, heap, *results, &cexpr);
+          VEC_safe_push(ce_s, stack, *results, &cexpr);
           if (address_p)
             break;
         }
@@ -2632,7 +2632,7 @@ static void get_constraint_for_component_ref(tree t, VEC(ce_s, heap) * *results,
         while (curr->next != NULL)
           curr = curr->next;
         cexpr.var = curr->id;
-        VEC_safe_push(ce_s, heap, *results, &cexpr);
+        VEC_safe_push(ce_s, stack, *results, &cexpr);
       } else
         /* Assert that we found *some* field there. The user couldn't be
            accessing *only* padding.  */
@@ -2662,7 +2662,7 @@ static void get_constraint_for_component_ref(tree t, VEC(ce_s, heap) * *results,
    DEREF (DEREF) = (temp = DEREF1; result = DEREF(temp))
    This is needed so that we can handle dereferencing DEREF constraints.  */
 
-static void do_deref(VEC(ce_s, heap) * *constraints) {
+static void do_deref(VEC(ce_s, stack) * *constraints) {
   struct constraint_expr *c;
   unsigned int i = 0;
 
@@ -2683,7 +2683,7 @@ static void do_deref(VEC(ce_s, heap) * *constraints) {
 
 /* Given a tree T, return the constraint expression for it.  */
 
-static void get_constraint_for_1(tree t, VEC(ce_s, heap) * *results,
+static void get_constraint_for_1(tree t, VEC(ce_s, stack) * *results,
                                  bool address_p) {
   struct constraint_expr temp;
 
@@ -2705,7 +2705,7 @@ static void get_constraint_for_1(tree t, VEC(ce_s, heap) * *results,
     temp.var = nothing_id;
     temp.type = ADDRESSOF;
     temp.offset = 0;
-    VEC_safe_push(ce_s, heap, *results, &temp);
+    VEC_safe_push(ce_s, stack, *results, &temp);
     return;
   }
 
@@ -2714,7 +2714,7 @@ static void get_constraint_for_1(tree t, VEC(ce_s, heap) * *results,
     temp.var = readonly_id;
     temp.type = SCALAR;
     temp.offset = 0;
-    VEC_safe_push(ce_s, heap, *results, &temp);
+    VEC_safe_push(ce_s, stack, *results, &temp);
     return;
   }
 
@@ -2777,12 +2777,12 @@ static void get_constraint_for_1(tree t, VEC(ce_s, heap) * *results,
   temp.type = ADDRESSOF;
   temp.var = anything_id;
   temp.offset = 0;
-  VEC_safe_push(ce_s, heap, *results, &temp);
+  VEC_safe_push(ce_s, stack, *results, &temp);
 }
 
 /* Given a gimple tree T, return the constraint expression vector for it.  */
 
-static void get_constraint_for(tree t, VEC(ce_s, heap) * *results) {
+static void get_constraint_for(tree t, VEC(ce_s, stack) * *results) {
   gcc_assert(VEC_length(ce_s, *results) == 0);
 
   get_constraint_for_1(t, results, false);
@@ -2923,7 +2923,8 @@ static unsigned int collapse_rest_of_var(unsigned int var) {
 
 static void do_structure_copy(tree lhsop, tree rhsop) {
   struct constraint_expr lhs, rhs, tmp;
-  VEC(ce_s, heap) *lhsc = NULL, *rhsc = NULL;
+  VEC(ce_s, stack) *lhsc = VEC_stack_alloc(ce_s, 8);
+  VEC(ce_s, stack) *rhsc = VEC_stack_alloc(ce_s, 8);
   varinfo_t p;
   unsigned HOST_WIDE_INT lhssize;
   unsigned HOST_WIDE_INT rhssize;
@@ -2937,8 +2938,8 @@ static void do_structure_copy(tree lhsop, tree rhsop) {
   lhs = *(VEC_last(ce_s, lhsc));
   rhs = *(VEC_last(ce_s, rhsc));
 
-  VEC_free(ce_s, heap, lhsc);
-  VEC_free(ce_s, heap, rhsc);
+  VEC_free(ce_s, stack, lhsc);
+  VEC_free(ce_s, stack, rhsc);
 
   /* If we have special var = x, swap it around.  */
   if (lhs.var <= integer_id && !(get_varinfo(rhs.var)->is_special_var)) {
@@ -3035,7 +3036,7 @@ static void do_structure_copy(tree lhsop, tree rhsop) {
 /* Create a constraint ID = OP.  */
 
 static void make_constraint_to(unsigned id, tree op) {
-  VEC(ce_s, heap) *rhsc = NULL;
+  VEC(ce_s, stack) *rhsc = VEC_stack_alloc(ce_s, 8);
   struct constraint_expr *c;
   struct constraint_expr includes;
   unsigned int j;
@@ -3047,7 +3048,7 @@ static void make_constraint_to(unsigned id, tree op) {
   get_constraint_for(op, &rhsc);
   for (j = 0; VEC_iterate(ce_s, rhsc, j, c); j++)
     process_constraint(new_constraint(includes, *c));
-  VEC_free(ce_s, heap, rhsc);
+  VEC_free(ce_s, stack, rhsc);
 }
 
 /* Make constraints necessary to make OP escape.  */
@@ -3081,7 +3082,7 @@ static void handle_rhs_call(gimple stmt) {
    the LHS point to global and escaped variables.  */
 
 static void handle_lhs_call(tree lhs, int flags) {
-  VEC(ce_s, heap) *lhsc = NULL;
+  VEC(ce_s, stack) *lhsc = VEC_stack_alloc(ce_s, 8);
   struct constraint_expr rhsc;
   unsigned int j;
   struct constraint_expr *lhsp;
@@ -3117,7 +3118,7 @@ static void handle_lhs_call(tree lhs, int flags) {
   }
   for (j = 0; VEC_iterate(ce_s, lhsc, j, lhsp); j++)
     process_constraint(new_constraint(*lhsp, rhsc));
-  VEC_free(ce_s, heap, lhsc);
+  VEC_free(ce_s, stack, lhsc);
 }
 
 /* For non-IPA mode, generate constraints necessary for a call of a
@@ -3125,7 +3126,7 @@ static void handle_lhs_call(tree lhs, int flags) {
 
 static void handle_const_call(gimple stmt) {
   tree lhs = gimple_call_lhs(stmt);
-  VEC(ce_s, heap) *lhsc = NULL;
+  VEC(ce_s, stack) *lhsc = VEC_stack_alloc(ce_s, 8);
   struct constraint_expr rhsc;
   unsigned int j, k;
   struct constraint_expr *lhsp;
@@ -3141,7 +3142,7 @@ static void handle_const_call(gimple stmt) {
     rhsc.type = ADDRESSOF;
     for (j = 0; VEC_iterate(ce_s, lhsc, j, lhsp); j++)
       process_constraint(new_constraint(*lhsp, rhsc));
-    VEC_free(ce_s, heap, lhsc);
+    VEC_free(ce_s, stack, lhsc);
     return;
   }
 
@@ -3163,21 +3164,21 @@ static void handle_const_call(gimple stmt) {
     tree arg = gimple_call_arg(stmt, k);
 
     if (could_have_pointers(arg)) {
-      VEC(ce_s, heap) *argc = NULL;
+      VEC(ce_s, stack) *argc = NULL;
       struct constraint_expr *argp;
       int i;
 
       get_constraint_for(arg, &argc);
       for (i = 0; VEC_iterate(ce_s, argc, i, argp); i++)
         process_constraint(new_constraint(tmpc, *argp));
-      VEC_free(ce_s, heap, argc);
+      VEC_free(ce_s, stack, argc);
     }
   }
 
   for (j = 0; VEC_iterate(ce_s, lhsc, j, lhsp); j++)
     process_constraint(new_constraint(*lhsp, tmpc));
 
-  VEC_free(ce_s, heap, lhsc);
+  VEC_free(ce_s, stack, lhsc);
 }
 
 /* For non-IPA mode, generate constraints necessary for a call to a
@@ -3203,7 +3204,7 @@ static void handle_pure_call(gimple stmt) {
   if (gimple_call_lhs(stmt) && could_have_pointers(gimple_call_lhs(stmt)) &&
       !(gimple_call_flags(stmt) & ECF_MALLOC)) {
     tree lhs = gimple_call_lhs(stmt);
-    VEC(ce_s, heap) *lhsc = NULL;
+    VEC(ce_s, stack) *lhsc = VEC_stack_alloc(ce_s, 8);
     struct constraint_expr rhsc;
     struct constraint_expr *lhsp;
     unsigned j;
@@ -3217,7 +3218,7 @@ static void handle_pure_call(gimple stmt) {
       rhsc.type = ADDRESSOF;
       for (j = 0; VEC_iterate(ce_s, lhsc, j, lhsp); j++)
         process_constraint(new_constraint(*lhsp, rhsc));
-      VEC_free(ce_s, heap, lhsc);
+      VEC_free(ce_s, stack, lhsc);
       return;
     }
 
@@ -3228,7 +3229,7 @@ static void handle_pure_call(gimple stmt) {
     rhsc.type = ADDRESSOF;
     for (j = 0; VEC_iterate(ce_s, lhsc, j, lhsp); j++)
       process_constraint(new_constraint(*lhsp, rhsc));
-    VEC_free(ce_s, heap, lhsc);
+    VEC_free(ce_s, stack, lhsc);
   }
 }
 
@@ -3239,8 +3240,8 @@ static void handle_pure_call(gimple stmt) {
 
 static void find_func_aliases(gimple origt) {
   gimple t = origt;
-  VEC(ce_s, heap) *lhsc = NULL;
-  VEC(ce_s, heap) *rhsc = NULL;
+  VEC(ce_s, stack) *lhsc = VEC_stack_alloc(ce_s, 8);
+  VEC(ce_s, stack) *rhsc = VEC_stack_alloc(ce_s, 8);
   struct constraint_expr *c;
   enum escape_type stmt_escape_type;
 
@@ -3398,7 +3399,7 @@ static void find_func_aliases(gimple origt) {
         temp.type = ADDRESSOF;
         temp.var = anything_id;
         temp.offset = 0;
-        VEC_safe_push(ce_s, heap, rhsc, &temp);
+        VEC_safe_push(ce_s, stack, rhsc, &temp);
       }
       for (j = 0; VEC_iterate(ce_s, lhsc, j, c); j++) {
         struct constraint_expr *c2;
@@ -3458,8 +3459,8 @@ static void find_func_aliases(gimple origt) {
      re-scan *all* statements.  */
   if (!in_ipa_mode)
     gimple_set_modified(origt, true);
-  VEC_free(ce_s, heap, rhsc);
-  VEC_free(ce_s, heap, lhsc);
+  VEC_free(ce_s, stack, rhsc);
+  VEC_free(ce_s, stack, lhsc);
 }
 
 /* Find the first varinfo in the same variable as START that overlaps with
@@ -182,6 +182,7 @@ extern const char *const tree_code_name[];
 DEF_VEC_P(tree);
 DEF_VEC_ALLOC_P(tree, gc);
 DEF_VEC_ALLOC_P(tree, heap);
+DEF_VEC_ALLOC_P_STACK(tree);
 
 /* Classify which part of the compiler has defined a given builtin function.
    Note that we assume below that this is no more than two bits.  */
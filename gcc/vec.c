@@ -39,6 +39,13 @@ struct vec_prefix {
   void *vec[1];
 };
 
+/* Number of heap vectors created and reallocated, and of stack vectors
+   created and moved to the heap, for -fmem-report.  */
+static unsigned long heap_vec_allocs;
+static unsigned long heap_vec_reallocs;
+static unsigned long stack_vec_allocs;
+static unsigned long stack_vec_spills;
+
 #ifdef GATHER_STATISTICS
 
 /* Store information about each particular vector.  */
@@ -275,6 +282,10 @@ static void *vec_heap_o_reserve_1(void *vec, int reserve, size_t vec_offset,
     free_overhead(pfx);
 #endif
 
+  if (vec)
+    heap_vec_reallocs++;
+  else
+    heap_vec_allocs++;
   vec = xrealloc(vec, vec_offset + alloc * elt_size);
   ((struct vec_prefix *)vec)->alloc = alloc;
   if (!pfx)
@@ -318,6 +329,109 @@ void *vec_heap_o_reserve_exact(void *vec, int reserve, size_t vec_offset,
                               true PASS_MEM_STAT);
 }
 
+/* The stack vectors that have not moved to the heap yet.  They are
+   freed in the reverse order of their allocation, so they are searched
+   from the end.  */
+typedef void *void_p;
+DEF_VEC_P(void_p);
+DEF_VEC_ALLOC_P(void_p, heap);
+static VEC(void_p, heap) * stack_vecs;
+
+/* Initialize the stack vector at SPACE, which has room for ALLOC
+   elements, and record it as being on the stack.  */
+
+void *vec_stack_p_reserve_exact_1(int alloc, void *space) {
+  struct vec_prefix *pfx = (struct vec_prefix *)space;
+
+  VEC_safe_push(void_p, heap, stack_vecs, space);
+  stack_vec_allocs++;
+
+  pfx->num = 0;
+  pfx->alloc = alloc;
+
+  return space;
+}
+
+/* Return the index of VEC in STACK_VECS, or -1 if it is not there.  */
+
+static int find_stack_vec(void *vec) {
+  int ix;
+
+  for (ix = VEC_length(void_p, stack_vecs) - 1; ix >= 0; --ix)
+    if (VEC_index(void_p, stack_vecs, ix) == vec)
+      return ix;
+  return -1;
+}
+
+/* As for vec_heap_o_reserve_1, but for stack vectors: a vector still on
+   the stack is copied to a new heap vector, and the stack space is left
+   to its function.  */
+
+static void *vec_stack_o_reserve_1(void *vec, int reserve, size_t vec_offset,
+                                   size_t elt_size, bool exact MEM_STAT_DECL) {
+  struct vec_prefix *pfx = (struct vec_prefix *)vec;
+  struct vec_prefix *newvec;
+  int ix = vec ? find_stack_vec(vec) : -1;
+
+  if (ix < 0)
+    return vec_heap_o_reserve_1(vec, reserve, vec_offset, elt_size,
+                                exact PASS_MEM_STAT);
+
+  VEC_ordered_remove(void_p, stack_vecs, ix);
+  stack_vec_spills++;
+
+  newvec = (struct vec_prefix *)vec_heap_o_reserve_1(
+      NULL, calculate_allocation(pfx, reserve, exact), vec_offset, elt_size,
+      true PASS_MEM_STAT);
+  newvec->num = pfx->num;
+  memcpy((char *)newvec + vec_offset, (char *)vec + vec_offset,
+         pfx->num * elt_size);
+
+  return newvec;
+}
+
+/* As for vec_heap_p_reserve, but for stack vectors.  */
+
+void *vec_stack_p_reserve(void *vec, int reserve MEM_STAT_DECL) {
+  return vec_stack_o_reserve_1(vec, reserve, offsetof(struct vec_prefix, vec),
+                               sizeof(void *), false PASS_MEM_STAT);
+}
+
+/* As for vec_heap_p_reserve_exact, but for stack vectors.  */
+
+void *vec_stack_p_reserve_exact(void *vec, int reserve MEM_STAT_DECL) {
+  return vec_stack_o_reserve_1(vec, reserve, offsetof(struct vec_prefix, vec),
+                               sizeof(void *), true PASS_MEM_STAT);
+}
+
+/* As for vec_heap_o_reserve, but for stack vectors.  */
+
+void *vec_stack_o_reserve(void *vec, int reserve, size_t vec_offset,
+                          size_t elt_size MEM_STAT_DECL) {
+  return vec_stack_o_reserve_1(vec, reserve, vec_offset, elt_size,
+                               false PASS_MEM_STAT);
+}
+
+/* As for vec_heap_o_reserve_exact, but for stack vectors.  */
+
+void *vec_stack_o_reserve_exact(void *vec, int reserve, size_t vec_offset,
+                                size_t elt_size MEM_STAT_DECL) {
+  return vec_stack_o_reserve_1(vec, reserve, vec_offset, elt_size,
+                               true PASS_MEM_STAT);
+}
+
+/* Free a stack vector, which only needs forgetting if it is still on
+   the stack.  */
+
+void vec_stack_free(void *vec) {
+  int ix = find_stack_vec(vec);
+
+  if (ix >= 0)
+    VEC_ordered_remove(void_p, stack_vecs, ix);
+  else
+    vec_heap_free(vec);
+}
+
 #if ENABLE_CHECKING
 /* Issue a vector domain error, and then fall over.  */
 
@@ -361,7 +475,14 @@ void dump_vec_loc_statistics(void) {
   size_t allocated = 0;
   size_t times = 0;
   int i;
+#endif
 
+  fprintf(stderr, "Vector totals: %lu heap allocations, %lu reallocations\n",
+          heap_vec_allocs, heap_vec_reallocs);
+  fprintf(stderr,
+          "Vector totals: %lu stack allocations, %lu moved to the heap\n",
+          stack_vec_allocs, stack_vec_spills);
+#ifdef GATHER_STATISTICS
   loc_array = XCNEWVEC(struct vec_descriptor *, vec_desc_hash->n_elements);
   fprintf(stderr, "Heap vectors:\n");
   fprintf(stderr, "\n%-48s %10s       %10s       %10s\n", "source location",
@@ -100,7 +100,12 @@ along with GCC; see the file COPYING3.  If not see
    allocation strategy, and can be either 'gc' or 'heap' for garbage
    collected and heap allocated respectively.  It can be 'none' to get
    a vector that must be explicitly allocated (for instance as a
-   trailing array of another structure).  The characters O, P and I
+   trailing array of another structure).  It can be 'stack' for a
+   vector whose first elements live in the frame of the function that
+   allocates it with VEC_stack_alloc, and that moves to the heap if it
+   outgrows them.  Stack vectors are defined with
+   DEF_VEC_ALLOC_{O,P,I}_STACK(TYPEDEF) and must be freed with VEC_free
+   before that function returns.  The characters O, P and I
    indicate whether TYPEDEF is a pointer (P), object (O) or integral
    (I) type.  Be careful to pick the correct one, as you'll get an
    awkward and inefficient API if you use the wrong one.  There is a
@@ -201,6 +206,18 @@ along with GCC; see the file COPYING3.  If not see
 
 #define VEC_free(T, A, V) (VEC_OP(T, A, free)(&V))
 
+/* Allocate new stack vector.
+   VEC(T,stack) *VEC_T_stack_alloc1(int reserve, VEC(T,stack) *space);
+
+   Allocate a vector with space for RESERVE objects in the frame of the
+   calling function, which must free it with VEC_free before returning.
+   Reserving more than RESERVE objects moves the vector to the heap.
+   Each call takes more stack, so do not use this in a loop.  */
+
+#define VEC_stack_alloc(T, N)                            \
+  (VEC_OP(T, stack, alloc1)(N, XALLOCAVAR(VEC(T, stack), \
+                                          VEC_embedded_size(T, N))))
+
 /* Use these to determine the required size and initialization of a
    vector embedded within another structure (as the final member).
 
@@ -428,6 +445,13 @@ extern void *vec_heap_p_reserve_exact(void *, int MEM_STAT_DECL);
 extern void *vec_heap_o_reserve(void *, int, size_t, size_t MEM_STAT_DECL);
 extern void *vec_heap_o_reserve_exact(void *, int, size_t,
                                       size_t MEM_STAT_DECL);
+extern void *vec_stack_p_reserve(void *, int MEM_STAT_DECL);
+extern void *vec_stack_p_reserve_exact(void *, int MEM_STAT_DECL);
+extern void *vec_stack_p_reserve_exact_1(int, void *);
+extern void *vec_stack_o_reserve(void *, int, size_t, size_t MEM_STAT_DECL);
+extern void *vec_stack_o_reserve_exact(void *, int, size_t,
+                                       size_t MEM_STAT_DECL);
+extern void vec_stack_free(void *);
 extern void dump_vec_loc_statistics(void);
 #ifdef GATHER_STATISTICS
 void vec_heap_free(void *);
@@ -504,6 +528,11 @@ extern void vec_assert_fail(const char *,
   VEC_TA(T, base, A);         \
   DEF_VEC_ALLOC_FUNC_I(T, A)  \
   struct vec_swallow_trailing_semi
+#define DEF_VEC_ALLOC_I_STACK(T) \
+  VEC_TA(T, base, stack);        \
+  DEF_VEC_ALLOC_FUNC_I(T, stack) \
+  DEF_VEC_ALLOC_FUNC_STACK(T)    \
+  struct vec_swallow_trailing_semi
 
 /* Vector of pointer to object.  */
 #define DEF_VEC_P(T)                                          \
@@ -519,6 +548,11 @@ extern void vec_assert_fail(const char *,
   VEC_TA(T, base, A);         \
   DEF_VEC_ALLOC_FUNC_P(T, A)  \
   struct vec_swallow_trailing_semi
+#define DEF_VEC_ALLOC_P_STACK(T) \
+  VEC_TA(T, base, stack);        \
+  DEF_VEC_ALLOC_FUNC_P(T, stack) \
+  DEF_VEC_ALLOC_FUNC_STACK(T)    \
+  struct vec_swallow_trailing_semi
 
 #define DEF_VEC_FUNC_P(T)                                                     \
   static inline unsigned VEC_OP(T, base, length)(const VEC(T, base) * vec_) { \
@@ -772,6 +806,11 @@ extern void vec_assert_fail(const char *,
   VEC_TA(T, base, A);         \
   DEF_VEC_ALLOC_FUNC_O(T, A)  \
   struct vec_swallow_trailing_semi
+#define DEF_VEC_ALLOC_O_STACK(T) \
+  VEC_TA(T, base, stack);        \
+  DEF_VEC_ALLOC_FUNC_O(T, stack) \
+  DEF_VEC_ALLOC_FUNC_STACK(T)    \
+  struct vec_swallow_trailing_semi
 
 #define DEF_VEC_FUNC_O(T)                                                      \
   static inline unsigned VEC_OP(T, base, length)(const VEC(T, base) * vec_) {  \
@@ -1098,4 +1137,11 @@ extern void vec_assert_fail(const char *,
                                          obj_ VEC_CHECK_PASS);                 \
   }
 
+/* The stack allocator, shared by the three flavors of stack vector.  */
+#define DEF_VEC_ALLOC_FUNC_STACK(T)                                            \
+  static inline VEC(T, stack) *                                                \
+      VEC_OP(T, stack, alloc1)(int alloc_, VEC(T, stack) * space_) {           \
+    return (VEC(T, stack) *)vec_stack_p_reserve_exact_1(alloc_, space_);       \
+  }
+
 #endif /* GCC_VEC_H */
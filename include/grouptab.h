@@ -0,0 +1,112 @@
+/* An open-addressing hash table probed a group of slots at a time.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+This file is part of the libiberty library.
+Libiberty is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+Libiberty is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Library General Public License for more details.
+
+You should have received a copy of the GNU Library General Public
+License along with libiberty; see the file COPYING.LIB.  If
+not, write to the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+Boston, MA 02110-1301, USA.  */
+
+/* This table has the same interface as the one in hashtab.h, but keeps
+   a byte of the hash code of every element next to the element itself
+   and searches GROUPTAB_GROUP_SIZE of those bytes at once, so most
+   failed comparisons never touch the elements.  A table created
+   without a hash function holds pointers that are hashed and compared
+   by address, with no indirect calls.  A table can also carry a value
+   for every element, making it a map.  */
+
+#ifndef GROUPTAB_H
+#define GROUPTAB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "ansidecl.h"
+#include "hashtab.h"
+
+/* The number of slots probed together.  The size of a table is always
+   a power of two and a multiple of this.  */
+#define GROUPTAB_GROUP_SIZE 16
+
+/* Control bytes of empty and deleted slots.  Those of live elements
+   have the top bit clear.  */
+#define GROUPTAB_EMPTY 0x80
+#define GROUPTAB_DELETED 0xfe
+
+/* Hash tables are of the following type.  The structure is visible only
+   so that the elements can be iterated over inline; as with htab, all
+   other work should go through the functions below.  */
+
+struct grouptab
+{
+  /* Pointers to the hash, comparison and cleanup functions.  HASH_F
+     and EQ_F are null for a table of pointers.  */
+  htab_hash hash_f;
+  htab_eq eq_f;
+  htab_del del_f;
+
+  /* The elements.  Empty and deleted slots are null.  */
+  void **entries;
+
+  /* For a map, the value of the element in the same slot, else null.  */
+  void **values;
+
+  /* For each slot, GROUPTAB_EMPTY, GROUPTAB_DELETED, or the low seven
+     bits of the hash code of its element.  */
+  unsigned char *control;
+
+  /* Number of slots, live elements and deleted slots.  */
+  size_t size;
+  size_t n_elements;
+  size_t n_deleted;
+
+  /* Number of searches, and of additional groups they probed.  */
+  unsigned int searches;
+  unsigned int collisions;
+};
+
+typedef struct grouptab *grouptab_t;
+
+extern grouptab_t grouptab_create (size_t, htab_hash, htab_eq, htab_del);
+extern grouptab_t grouptab_create_map (size_t, htab_hash, htab_eq, htab_del);
+extern void grouptab_delete (grouptab_t);
+extern void grouptab_empty (grouptab_t);
+
+extern void *grouptab_find (grouptab_t, const void *);
+extern void **grouptab_find_slot (grouptab_t, const void *,
+				  enum insert_option);
+extern void *grouptab_find_with_hash (grouptab_t, const void *, hashval_t);
+extern void **grouptab_find_slot_with_hash (grouptab_t, const void *,
+					    hashval_t, enum insert_option);
+extern void grouptab_clear_slot (grouptab_t, void **);
+extern void grouptab_remove_elt (grouptab_t, void *);
+extern void grouptab_remove_elt_with_hash (grouptab_t, void *, hashval_t);
+
+extern void grouptab_traverse (grouptab_t, htab_trav, void *);
+
+extern size_t grouptab_size (grouptab_t);
+extern size_t grouptab_elements (grouptab_t);
+extern double grouptab_collisions (grouptab_t);
+
+/* The hash code that a table of pointers uses for P.  */
+extern hashval_t grouptab_hash_pointer (const void *);
+
+/* Return the value in the same slot of a map as the element in SLOT.  */
+#define GROUPTAB_SLOT_VALUE(TAB, SLOT) (&(TAB)->values[(SLOT) - (TAB)->entries])
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* GROUPTAB_H */
@@ -0,0 +1,84 @@
+/* An indexed binary heap datatype.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+This file is part of the libiberty library.
+Libiberty is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+Libiberty is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Library General Public License for more details.
+
+You should have received a copy of the GNU Library General Public
+License along with libiberty; see the file COPYING.LIB.  If
+not, write to the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+Boston, MA 02110-1301, USA.  */
+
+/* A priority queue with the interface of fibheap.h, kept as a binary
+   heap in one array of keys and data.  Inserting an element returns a
+   node, a small integer that names the element until it is extracted
+   or deleted and through which its key can be changed in either
+   direction.  Nodes are never zero, so a node cast to a pointer is
+   never null and can be kept in an aux field that is null for
+   elements not in the heap.
+
+   Worst case time for operations:
+
+   Insert, ExtractMin, ReplaceKey, DeleteNode: O(lg n).
+   Min, Empty: O(1).  */
+
+#ifndef IDXHEAP_H
+#define IDXHEAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "ansidecl.h"
+
+typedef long idxheapkey_t;
+typedef size_t idxnode_t;
+
+/* An element of the heap.  */
+
+struct idxheap_entry
+{
+  idxheapkey_t key;
+  void *data;
+  idxnode_t node;
+};
+
+typedef struct idxheap
+{
+  /* The elements, in heap order, and the number of them.  */
+  struct idxheap_entry *entries;
+  size_t nodes;
+  size_t alloc;
+
+  /* For each node in use, the index of its element in ENTRIES.  For
+     each free node, the next free node, or zero.  */
+  size_t *index;
+  size_t index_alloc;
+  idxnode_t free_node;
+} *idxheap_t;
+
+extern idxheap_t idxheap_new (void);
+extern idxnode_t idxheap_insert (idxheap_t, idxheapkey_t, void *);
+extern int idxheap_empty (idxheap_t);
+extern idxheapkey_t idxheap_min_key (idxheap_t);
+extern void *idxheap_min (idxheap_t);
+extern void *idxheap_extract_min (idxheap_t);
+extern idxheapkey_t idxheap_key (idxheap_t, idxnode_t);
+extern void *idxheap_data (idxheap_t, idxnode_t);
+extern idxheapkey_t idxheap_replace_key (idxheap_t, idxnode_t, idxheapkey_t);
+extern void *idxheap_delete_node (idxheap_t, idxnode_t);
+extern void idxheap_delete (idxheap_t);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* IDXHEAP_H */
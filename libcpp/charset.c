@@ -1647,7 +1647,10 @@ _cpp_interpret_identifier (cpp_reader *pfile, const uchar *id, size_t len)
    INPUT is expected to have been allocated with xmalloc.  This
    function will either set *BUFFER_START to INPUT, or free it and set
    *BUFFER_START to a pointer to another xmalloc-allocated block of
-   memory.  */
+   memory.  The exception is input that needs no conversion and whose
+   SIZE leaves room for the terminator, which is used as is; the
+   caller may then have obtained INPUT some other way, such as from
+   mmap.  */
 uchar * 
 _cpp_convert_input (cpp_reader *pfile, const char *input_charset,
 		    uchar *input, size_t size, size_t len,
@@ -1683,9 +1686,10 @@ _cpp_convert_input (cpp_reader *pfile, const char *input_charset,
     iconv_close (input_cset.cd);
 
   /* Resize buffer if we allocated substantially too much, or if we
-     haven't enough space for the \n-terminator.  */
-  if (to.len + 4096 < to.asize || to.len >= to.asize)
-    to.text = XRESIZEVEC (uchar, to.text, to.len + 1);
+     haven't enough space for the \n-terminator and the padding that
+     follows it.  */
+  if (to.len + 4096 < to.asize || to.len + CPP_BUFFER_PADDING > to.asize)
+    to.text = XRESIZEVEC (uchar, to.text, to.len + CPP_BUFFER_PADDING);
 
   /* If the file is using old-school Mac line endings (\r only),
      terminate with another \r, not an \n, so that we do not mistake
@@ -1716,6 +1720,15 @@ _cpp_convert_input (cpp_reader *pfile, const char *input_charset,
   return buffer;
 }
 
+/* Return true if input in INPUT_CHARSET needs no conversion to the
+   source character set, so that it can be lexed in place.  This
+   matches the test init_iconv_desc makes.  */
+bool
+_cpp_input_charset_identity_p (const char *input_charset)
+{
+  return !strcasecmp (SOURCE_CHARSET, input_charset);
+}
+
 /* Decide on the default encoding to assume for input files.  */
 const char *
 _cpp_default_encoding (void)
@@ -606,6 +606,7 @@ do_undef (cpp_reader *pfile)
 	    _cpp_warn_if_unused_macro (pfile, node, NULL);
 
 	  _cpp_free_definition (node);
+	  _cpp_macro_changed (pfile, node);
 	}
     }
 
@@ -631,6 +632,7 @@ void
 cpp_undef_all (cpp_reader *pfile)
 {
   cpp_forall_identifiers (pfile, undefine_macros, NULL);
+  _cpp_macro_changed (pfile, NULL);
 }
 
 
@@ -1435,6 +1437,7 @@ do_pragma_poison (cpp_reader *pfile)
 		   NODE_NAME (hp));
       _cpp_free_definition (hp);
       hp->flags |= NODE_POISONED | NODE_DIAGNOSTIC;
+      _cpp_macro_changed (pfile, hp);
     }
   pfile->state.poisoned_ok = 0;
 }
@@ -2249,6 +2252,7 @@ cpp_pop_definition (cpp_reader *pfile, const char *str, cpp_macro *dfn)
     }
   if (node->type != NT_VOID)
     _cpp_free_definition (node);
+  _cpp_macro_changed (pfile, node);
 
   if (dfn)
     {
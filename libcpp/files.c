@@ -32,6 +32,20 @@ along with this program; see the file COPYING3.  If not see
 #include "md5.h"
 #include <dirent.h>
 
+#if defined (HAVE_SYS_MMAN_H) && defined (HAVE_MMAP)
+# include <sys/mman.h>
+# ifndef MAP_FAILED
+#  define MAP_FAILED ((void *) -1)
+# endif
+# define USE_MMAP_FILES 1
+#endif
+
+/* Regular files at least this many pages long are mapped into memory
+   rather than read, provided the last page has room for the
+   terminating newline that _cpp_clean_line relies on.  Mapping small
+   files costs more than it saves.  */
+#define MMAP_THRESHOLD 2
+
 /* Variable length record files on VMS will have a stat size that includes
    record control characters that won't be included in the read size.  */
 #ifdef VMS
@@ -78,6 +92,10 @@ struct _cpp_file
      BUFFER; when freeing, this this pointer must be used instead.  */
   const uchar *buffer_start;
 
+  /* If nonzero, BUFFER_START was obtained from mmap() and this is the
+     length of the mapping; otherwise it was allocated with xmalloc.  */
+  size_t buffer_map_len;
+
   /* The macro, if any, preventing re-inclusion.  */
   const cpp_hashnode *cmacro;
 
@@ -108,6 +126,9 @@ struct _cpp_file
   /* If this file is the main file.  */
   bool main_file;
 
+  /* If this file has been considered for the dependencies.  */
+  bool dep_considered;
+
   /* If BUFFER above contains the true contents of the file.  */
   bool buffer_valid;
 };
@@ -166,12 +187,80 @@ struct file_hash_entry_pool
   struct file_hash_entry pool[FILE_HASH_POOL_SIZE];
 };
 
+/* The listing of an include directory, as recorded in the include
+   cache file named by -finclude-cache.  A name that does not appear
+   in a current listing cannot be opened in that directory, so the
+   open() can be skipped.  */
+struct dir_listing
+{
+  /* The absolute name of the directory, which is the hash key.  */
+  const char *key;
+
+  /* The directory's inode and modification time when it was read.
+     The listing is current as long as they have not changed.  */
+  time_t mtime;
+  ino_t ino;
+
+  /* The names in the directory, sorted with filename_cmp.  */
+  const char **names;
+  size_t n_names;
+
+  /* True if the listing was checked against the directory during
+     this compilation, and found current or reread.  */
+  bool checked;
+
+  /* True if the listing should be written back to the cache file.  */
+  bool save;
+};
+
+/* The controlling macro of a header, as recorded in the include
+   cache.  If the header is unchanged and the macro is already
+   defined when it is first included, it is not read at all.  */
+struct include_guard
+{
+  /* The absolute name of the header, which is the hash key.  */
+  const char *key;
+
+  /* The name of the controlling macro.  */
+  const char *macro;
+
+  /* The header's modification time, size and inode when its
+     controlling macro was found.  */
+  time_t mtime;
+  off_t size;
+  ino_t ino;
+};
+
+/* The include cache of a reader.  */
+struct include_cache
+{
+  /* The directory listings, hashed by KEY.  */
+  htab_t listings;
+
+  /* The controlling macros of headers, hashed by KEY.  */
+  htab_t guards;
+
+  /* Memory holding the names read from the cache file.  */
+  char *buffer;
+
+  /* True if the cache file needs to be rewritten.  */
+  bool dirty;
+};
+
+/* The first line of an include cache file.  */
+static const char include_cache_magic[] = "cpp-include-cache 1\n";
+
+/* Marks a directory whose lookups don't use the include cache.  */
+static struct dir_listing no_listing;
+
 static bool open_file (_cpp_file *file);
 static bool pch_open_file (cpp_reader *pfile, _cpp_file *file,
 			   bool *invalid_pch);
 static bool find_file_in_dir (cpp_reader *pfile, _cpp_file *file,
 			      bool *invalid_pch);
 static bool read_file_guts (cpp_reader *pfile, _cpp_file *file);
+static bool map_file (cpp_reader *pfile, _cpp_file *file);
+static void release_file_buffer (_cpp_file *file);
 static bool read_file (cpp_reader *pfile, _cpp_file *file);
 static bool should_stack_file (cpp_reader *, _cpp_file *file, bool import);
 static struct cpp_dir *search_path_head (cpp_reader *, const char *fname,
@@ -196,6 +285,12 @@ static bool validate_pch (cpp_reader *, _cpp_file *file, const char *pchname);
 static int pchf_save_compare (const void *e1, const void *e2);
 static int pchf_compare (const void *d_p, const void *e_p);
 static bool check_file_against_entries (cpp_reader *, _cpp_file *, bool);
+static struct include_cache *read_include_cache (cpp_reader *);
+static struct dir_listing *dir_listing_for (cpp_reader *, cpp_dir *);
+static bool include_cache_may_exist (cpp_reader *, _cpp_file *);
+static void include_cache_find_guard (cpp_reader *, _cpp_file *);
+static void include_cache_record_guard (cpp_reader *, _cpp_file *);
+static void add_file_dep (cpp_reader *, _cpp_file *);
 
 /* Given a filename in FILE->PATH, with the empty string interpreted
    as <stdin>, open it.
@@ -345,6 +440,14 @@ find_file_in_dir (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch)
 {
   char *path;
 
+  if (CPP_OPTION (pfile, include_cache_file)
+      && !include_cache_may_exist (pfile, file))
+    {
+      file->err_no = ENOENT;
+      file->path = file->name;
+      return false;
+    }
+
   if (CPP_OPTION (pfile, remap) && (path = remap_filename (pfile, file)))
     ;
   else
@@ -568,6 +671,73 @@ _cpp_find_file (cpp_reader *pfile, const char *fname, cpp_dir *start_dir, bool f
   return file;
 }
 
+/* Try to map the regular file FILE into memory instead of reading it,
+   returning true on success.  The mapping is private and the lexer
+   lexes straight out of it, so this is only done when no charset
+   conversion is needed.  The file must not end on a page boundary:
+   the slack at the end of the last page holds the newline terminator
+   written by _cpp_convert_input, and any bytes that _cpp_clean_line
+   does modify are copied on write rather than written back.  */
+static bool
+map_file (cpp_reader *pfile, _cpp_file *file)
+{
+#ifdef USE_MMAP_FILES
+  static size_t pagesize;
+  size_t size, map_len;
+  void *map;
+
+  if (!pagesize)
+    {
+#ifdef _SC_PAGESIZE
+      pagesize = sysconf (_SC_PAGESIZE);
+#else
+      pagesize = getpagesize ();
+#endif
+    }
+
+  size = file->st.st_size;
+  map_len = (size + pagesize - 1) & ~(pagesize - 1);
+  if (size / pagesize < MMAP_THRESHOLD
+      || map_len - size < CPP_BUFFER_PADDING
+      || !_cpp_input_charset_identity_p (CPP_OPTION (pfile, input_charset)))
+    return false;
+
+  map = mmap (NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	      file->fd, 0);
+  if (map == MAP_FAILED)
+    return false;
+
+  /* The padding asked for is within the mapping, so this never
+     reallocates.  */
+  file->buffer = _cpp_convert_input (pfile,
+				     CPP_OPTION (pfile, input_charset),
+				     (uchar *) map, size + CPP_BUFFER_PADDING,
+				     size, &file->buffer_start,
+				     &file->st.st_size);
+  file->buffer_map_len = map_len;
+  file->buffer_valid = true;
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* Release the contents of FILE read by read_file_guts.  */
+static void
+release_file_buffer (_cpp_file *file)
+{
+#ifdef USE_MMAP_FILES
+  if (file->buffer_map_len)
+    munmap ((void *) file->buffer_start, file->buffer_map_len);
+  else
+#endif
+    free ((void *) file->buffer_start);
+
+  file->buffer_start = NULL;
+  file->buffer_map_len = 0;
+}
+
 /* Read a file into FILE->buffer, returning true on success.
 
    If FILE->fd is something weird, like a block device, we don't want
@@ -606,6 +776,9 @@ read_file_guts (cpp_reader *pfile, _cpp_file *file)
 	  return false;
 	}
 
+      if (map_file (pfile, file))
+	return true;
+
       size = file->st.st_size;
     }
   else
@@ -614,7 +787,7 @@ read_file_guts (cpp_reader *pfile, _cpp_file *file)
        the majority of C source files.  */
     size = 8 * 1024;
 
-  buf = XNEWVEC (uchar, size + 1);
+  buf = XNEWVEC (uchar, size + CPP_BUFFER_PADDING);
   total = 0;
   while ((count = read (file->fd, buf + total, size - total)) > 0)
     {
@@ -625,7 +798,7 @@ read_file_guts (cpp_reader *pfile, _cpp_file *file)
 	  if (regular)
 	    break;
 	  size *= 2;
-	  buf = XRESIZEVEC (uchar, buf, size + 1);
+	  buf = XRESIZEVEC (uchar, buf, size + CPP_BUFFER_PADDING);
 	}
     }
 
@@ -641,7 +814,7 @@ read_file_guts (cpp_reader *pfile, _cpp_file *file)
 
   file->buffer = _cpp_convert_input (pfile,
 				     CPP_OPTION (pfile, input_charset),
-				     buf, size, total,
+				     buf, size + CPP_BUFFER_PADDING, total,
 				     &file->buffer_start,
 				     &file->st.st_size);
   file->buffer_valid = true;
@@ -699,6 +872,26 @@ should_stack_file (cpp_reader *pfile, _cpp_file *file, bool import)
 	return false;
     }
 
+  /* If the file has not been read yet, the include cache may know
+     its header guard.  The file is then skipped without being read,
+     but it must still appear in the dependencies.  Its descriptor is
+     closed; read_file reopens it if the guard is ever undefined.  */
+  if (CPP_OPTION (pfile, include_cache_file)
+      && file->cmacro == NULL && file->stack_count == 0 && !file->pchname)
+    {
+      include_cache_find_guard (pfile, file);
+      if (file->cmacro && file->cmacro->type == NT_MACRO)
+	{
+	  if (file->fd != -1)
+	    {
+	      close (file->fd);
+	      file->fd = -1;
+	    }
+	  add_file_dep (pfile, file);
+	  return false;
+	}
+    }
+
   /* Skip if the file had a header guard and the macro is defined.
      PCH relies on this appearing before the PCH handler below.  */
   if (file->cmacro && file->cmacro->type == NT_MACRO)
@@ -782,6 +975,27 @@ should_stack_file (cpp_reader *pfile, _cpp_file *file, bool import)
   return f == NULL;
 }
 
+/* Add FILE to the dependencies the first time it is included, unless
+   it is a system header and those are not wanted.  */
+static void
+add_file_dep (cpp_reader *pfile, _cpp_file *file)
+{
+  int sysp;
+
+  if (file->dep_considered)
+    return;
+  file->dep_considered = true;
+
+  if (pfile->buffer == NULL || file->dir == NULL)
+    sysp = 0;
+  else
+    sysp = MAX (pfile->buffer->sysp,  file->dir->sysp);
+
+  if (CPP_OPTION (pfile, deps.style) > !!sysp
+      && (!file->main_file || !CPP_OPTION (pfile, deps.ignore_main_file)))
+    deps_add_dep (pfile->deps, file->path);
+}
+
 /* Place the file referenced by FILE into a new buffer on the buffer
    stack if possible.  IMPORT is true if this stacking attempt is
    because of a #import directive.  Returns true if a buffer is
@@ -801,11 +1015,7 @@ _cpp_stack_file (cpp_reader *pfile, _cpp_file *file, bool import)
     sysp = MAX (pfile->buffer->sysp,  file->dir->sysp);
 
   /* Add the file to the dependencies on its first inclusion.  */
-  if (CPP_OPTION (pfile, deps.style) > !!sysp && !file->stack_count)
-    {
-      if (!file->main_file || !CPP_OPTION (pfile, deps.ignore_main_file))
-	deps_add_dep (pfile->deps, file->path);
-    }
+  add_file_dep (pfile, file);
 
   /* Clear buffer_valid since _cpp_clean_line messes it up.  */
   file->buffer_valid = false;
@@ -977,7 +1187,7 @@ static void
 destroy_cpp_file (_cpp_file *file)
 {
   if (file->buffer_start)
-    free ((void *) file->buffer_start);
+    release_file_buffer (file);
   free ((void *) file->name);
   free (file);
 }
@@ -1173,6 +1383,14 @@ _cpp_cleanup_files (cpp_reader *pfile)
   obstack_free (&pfile->nonexistent_file_ob, 0);
   free_file_hash_entries (pfile);
   destroy_all_cpp_files (pfile);
+  if (pfile->include_cache)
+    {
+      htab_delete (pfile->include_cache->listings);
+      htab_delete (pfile->include_cache->guards);
+      free (pfile->include_cache->buffer);
+      free (pfile->include_cache);
+      pfile->include_cache = NULL;
+    }
 }
 
 /* Make the parser forget about files it has seen.  This can be useful
@@ -1337,15 +1555,18 @@ _cpp_pop_file_buffer (cpp_reader *pfile, _cpp_file *file)
   /* Record the inclusion-preventing macro, which could be NULL
      meaning no controlling macro.  */
   if (pfile->mi_valid && file->cmacro == NULL)
-    file->cmacro = pfile->mi_cmacro;
+    {
+      file->cmacro = pfile->mi_cmacro;
+      if (file->cmacro && CPP_OPTION (pfile, include_cache_file))
+	include_cache_record_guard (pfile, file);
+    }
 
   /* Invalidate control macros in the #including file.  */
   pfile->mi_valid = false;
 
   if (file->buffer_start)
     {
-      free ((void *) file->buffer_start);
-      file->buffer_start = NULL;
+      release_file_buffer (file);
       file->buffer = NULL;
       file->buffer_valid = false;
     }
@@ -1374,6 +1595,7 @@ cpp_set_include_chains (cpp_reader *pfile, cpp_dir *quote, cpp_dir *bracket,
   for (; quote; quote = quote->next)
     {
       quote->name_map = NULL;
+      quote->listing = NULL;
       quote->len = strlen (quote->name);
       if (quote == bracket)
 	pfile->bracket_include = bracket;
@@ -1804,3 +2026,561 @@ check_file_against_entries (cpp_reader *pfile ATTRIBUTE_UNUSED,
   return bsearch (&d, pchf->entries, pchf->count, sizeof (struct pchf_entry),
 		  pchf_compare) != NULL;
 }
+
+/* Hash and compare dir_listing entries by their KEY.  */
+
+static hashval_t
+dir_listing_hash (const void *p)
+{
+  return htab_hash_string (((const struct dir_listing *) p)->key);
+}
+
+static int
+dir_listing_eq (const void *p, const void *q)
+{
+  return strcmp (((const struct dir_listing *) p)->key,
+		 (const char *) q) == 0;
+}
+
+/* Free a dir_listing.  Names read from the cache file live in the
+   cache's buffer, and names read from a directory on
+   PFILE->nonexistent_file_ob, so only the array of them is freed.  */
+
+static void
+dir_listing_free (void *p)
+{
+  struct dir_listing *listing = (struct dir_listing *) p;
+
+  free ((void *) listing->key);
+  free (listing->names);
+  free (listing);
+}
+
+static int
+dir_listing_name_cmp (const void *p, const void *q)
+{
+  return filename_cmp (*(const char *const *) p, *(const char *const *) q);
+}
+
+/* Likewise for include_guard entries.  */
+
+static hashval_t
+include_guard_hash (const void *p)
+{
+  return htab_hash_string (((const struct include_guard *) p)->key);
+}
+
+static int
+include_guard_eq (const void *p, const void *q)
+{
+  return strcmp (((const struct include_guard *) p)->key,
+		 (const char *) q) == 0;
+}
+
+static void
+include_guard_free (void *p)
+{
+  struct include_guard *guard = (struct include_guard *) p;
+
+  free ((void *) guard->key);
+  free ((void *) guard->macro);
+  free (guard);
+}
+
+/* Return the include cache key for the file or directory NAME, a
+   malloced absolute name without trailing directory separators.  */
+
+static char *
+include_cache_key (const char *name)
+{
+  char *key;
+  size_t len;
+
+  if (IS_ABSOLUTE_PATH (name))
+    key = xstrdup (name);
+  else
+    key = concat (getpwd (), "/", name, NULL);
+  len = strlen (key);
+  while (len > 1 && IS_DIR_SEPARATOR (key[len - 1]))
+    key[--len] = '\0';
+
+  return key;
+}
+
+/* Enter the header guard in the line P of the include cache file,
+   which has the form "MTIME SIZE INO MACRO NAME", into CACHE.
+   Returns false if the line is malformed.  */
+
+static bool
+read_include_guard (struct include_cache *cache, char *p)
+{
+  struct include_guard *guard;
+  unsigned long mtime, size, ino;
+  char *macro;
+  void **slot;
+
+  mtime = strtoul (p, &p, 10);
+  size = strtoul (p, &p, 10);
+  ino = strtoul (p, &p, 10);
+  if (*p++ != ' ')
+    return false;
+  macro = p;
+  p = strchr (p, ' ');
+  if (p == NULL || p == macro || p[1] == '\0')
+    return false;
+  *p++ = '\0';
+
+  slot = htab_find_slot_with_hash (cache->guards, p, htab_hash_string (p),
+				   INSERT);
+  if (*slot)
+    return false;
+
+  guard = XNEW (struct include_guard);
+  guard->key = xstrdup (p);
+  guard->macro = xstrdup (macro);
+  guard->mtime = (time_t) mtime;
+  guard->size = (off_t) size;
+  guard->ino = (ino_t) ino;
+  *slot = guard;
+
+  return true;
+}
+
+/* Read the include cache file named by -finclude-cache, and return
+   the include cache of PFILE.  A missing or malformed file just
+   gives an empty cache.  */
+
+static struct include_cache *
+read_include_cache (cpp_reader *pfile)
+{
+  const char *fname = CPP_OPTION (pfile, include_cache_file);
+  struct include_cache *cache;
+  struct stat st;
+  char *p, *end;
+  FILE *f;
+
+  cache = XCNEW (struct include_cache);
+  cache->listings = htab_create_alloc (31, dir_listing_hash, dir_listing_eq,
+				       dir_listing_free, xcalloc, free);
+  cache->guards = htab_create_alloc (127, include_guard_hash,
+				     include_guard_eq, include_guard_free,
+				     xcalloc, free);
+  pfile->include_cache = cache;
+
+  f = fopen (fname, "rb");
+  if (f == NULL)
+    return cache;
+
+  if (fstat (fileno (f), &st) != 0 || !S_ISREG (st.st_mode)
+      || st.st_size < (off_t) sizeof (include_cache_magic) - 1)
+    goto done;
+
+  cache->buffer = XNEWVEC (char, st.st_size + 1);
+  if (fread (cache->buffer, 1, st.st_size, f) != (size_t) st.st_size
+      || memcmp (cache->buffer, include_cache_magic,
+		 sizeof (include_cache_magic) - 1))
+    goto done;
+
+  /* Each directory is a line "D MTIME INO COUNT NAME", followed by
+     COUNT lines each holding the name of one entry.  Each header
+     guard is a line "G MTIME SIZE INO MACRO NAME".  */
+  cache->buffer[st.st_size] = '\0';
+  p = cache->buffer + sizeof (include_cache_magic) - 1;
+  end = cache->buffer + st.st_size;
+  while (p < end)
+    {
+      struct dir_listing *listing;
+      unsigned long mtime, ino, count, i;
+      hashval_t hash;
+      char *nl;
+      void **slot;
+
+      nl = strchr (p, '\n');
+      if (nl == NULL)
+	break;
+      *nl = '\0';
+      if (*p == 'G')
+	{
+	  if (!read_include_guard (cache, p + 1))
+	    break;
+	  p = nl + 1;
+	  continue;
+	}
+      if (*p != 'D')
+	break;
+      mtime = strtoul (p + 1, &p, 10);
+      ino = strtoul (p, &p, 10);
+      count = strtoul (p, &p, 10);
+      if (*p++ != ' ' || *p == '\0')
+	break;
+
+      listing = XCNEW (struct dir_listing);
+      listing->key = xstrdup (p);
+      listing->mtime = (time_t) mtime;
+      listing->ino = (ino_t) ino;
+      listing->names = XNEWVEC (const char *, count ? count : 1);
+      listing->save = true;
+      for (i = 0, p = nl + 1; i < count && p < end; i++, p = nl + 1)
+	{
+	  nl = strchr (p, '\n');
+	  if (nl == NULL)
+	    break;
+	  *nl = '\0';
+	  listing->names[i] = p;
+	}
+      listing->n_names = i;
+
+      hash = htab_hash_string (listing->key);
+      if (i != count
+	  || htab_find_with_hash (cache->listings, listing->key, hash))
+	{
+	  dir_listing_free (listing);
+	  break;
+	}
+      slot = htab_find_slot_with_hash (cache->listings, listing->key, hash,
+				       INSERT);
+      *slot = listing;
+    }
+
+  /* A truncated file is rewritten at the end of the compilation.  */
+  if (p < end)
+    cache->dirty = true;
+
+ done:
+  fclose (f);
+  return cache;
+}
+
+/* Return the listing of the include directory DIR, reading it from
+   the file system if the cached copy is missing or out of date.
+   Returns &no_listing if lookups in DIR must probe the file system
+   as usual.  */
+
+static struct dir_listing *
+dir_listing_for (cpp_reader *pfile, cpp_dir *dir)
+{
+  struct include_cache *cache = pfile->include_cache;
+  struct dir_listing *listing;
+  const char *dname;
+  char *key;
+  struct stat st;
+  struct dirent *d;
+  DIR *dirp;
+  size_t alloc;
+  void **slot;
+  bool save;
+
+  if (dir->listing)
+    return dir->listing;
+
+  /* Directories that construct or remap file names, and the pseudo
+     directory of absolute file names, are not listed.  */
+  if (dir == &pfile->no_search_path || dir->construct
+      || CPP_OPTION (pfile, remap))
+    return dir->listing = &no_listing;
+
+  if (cache == NULL)
+    cache = read_include_cache (pfile);
+
+  dname = dir->len ? dir->name : ".";
+  key = include_cache_key (dname);
+
+  listing = (struct dir_listing *)
+    htab_find_with_hash (cache->listings, key, htab_hash_string (key));
+  if (listing && listing->checked)
+    {
+      free (key);
+      return dir->listing = listing;
+    }
+
+  /* A directory that can't be read gets no listing; probing it fails
+     the same way it always did.  The directory is examined before it
+     is read, so that a name added meanwhile at worst causes another
+     rescan next time.  */
+  dirp = NULL;
+  if (stat (dname, &st) == 0 && S_ISDIR (st.st_mode))
+    {
+      if (listing && listing->mtime == st.st_mtime
+	  && listing->ino == st.st_ino)
+	{
+	  free (key);
+	  listing->checked = true;
+	  return dir->listing = listing;
+	}
+      dirp = opendir (dname);
+    }
+
+  if (dirp == NULL)
+    {
+      free (key);
+      if (listing && listing->save)
+	{
+	  listing->save = false;
+	  cache->dirty = true;
+	}
+      return dir->listing = &no_listing;
+    }
+
+  if (listing)
+    {
+      free ((void *) listing->key);
+      free (listing->names);
+    }
+  else
+    listing = XNEW (struct dir_listing);
+  listing->key = key;
+  listing->mtime = st.st_mtime;
+  listing->ino = st.st_ino;
+  listing->n_names = 0;
+  listing->checked = true;
+  alloc = 64;
+  listing->names = XNEWVEC (const char *, alloc);
+
+  /* A directory modified in the current second might change again
+     without its modification time changing, so its listing is only
+     good for this compilation.  Names containing newlines can't be
+     written to the cache file.  */
+  save = st.st_mtime < time (NULL);
+  while ((d = readdir (dirp)) != NULL)
+    {
+      if (listing->n_names == alloc)
+	{
+	  alloc *= 2;
+	  listing->names = XRESIZEVEC (const char *, listing->names, alloc);
+	}
+      listing->names[listing->n_names++]
+	= (const char *) obstack_copy0 (&pfile->nonexistent_file_ob,
+					d->d_name, strlen (d->d_name));
+      if (strchr (d->d_name, '\n'))
+	save = false;
+    }
+  closedir (dirp);
+
+  qsort (listing->names, listing->n_names, sizeof (const char *),
+	 dir_listing_name_cmp);
+  listing->save = save;
+  cache->dirty = true;
+  slot = htab_find_slot_with_hash (cache->listings, listing->key,
+				   htab_hash_string (listing->key), INSERT);
+  *slot = listing;
+
+  return dir->listing = listing;
+}
+
+/* Return false if FILE->name certainly does not exist in FILE->dir,
+   according to the include cache.  The first component of the name
+   must be listed in the directory; for a plain file name, so may its
+   precompiled header.  */
+
+static bool
+include_cache_may_exist (cpp_reader *pfile, _cpp_file *file)
+{
+  struct dir_listing *listing = dir_listing_for (pfile, file->dir);
+  const char *name = file->name;
+  const char *p;
+  char *component;
+  size_t len;
+
+  if (listing == &no_listing)
+    return true;
+
+  for (p = name; *p && !IS_DIR_SEPARATOR (*p); p++)
+    ;
+  len = p - name;
+  component = (char *) alloca (len + sizeof (".gch"));
+  memcpy (component, name, len);
+  component[len] = '\0';
+
+  if (bsearch (&component, listing->names, listing->n_names,
+	       sizeof (const char *), dir_listing_name_cmp))
+    return true;
+
+  if (*p == '\0' && pfile->cb.valid_pch)
+    {
+      memcpy (component + len, ".gch", sizeof (".gch"));
+      if (bsearch (&component, listing->names, listing->n_names,
+		   sizeof (const char *), dir_listing_name_cmp))
+	return true;
+    }
+
+  return false;
+}
+
+/* Write one listing to the include cache file F.  */
+
+static int
+write_dir_listing (void **slot, void *f)
+{
+  struct dir_listing *listing = (struct dir_listing *) *slot;
+  size_t i;
+
+  if (listing->save)
+    {
+      fprintf ((FILE *) f, "D %lu %lu %lu %s\n",
+	       (unsigned long) listing->mtime, (unsigned long) listing->ino,
+	       (unsigned long) listing->n_names, listing->key);
+      for (i = 0; i < listing->n_names; i++)
+	fprintf ((FILE *) f, "%s\n", listing->names[i]);
+    }
+
+  return 1;
+}
+
+/* Write one header guard to the include cache file F.  */
+
+static int
+write_include_guard (void **slot, void *f)
+{
+  struct include_guard *guard = (struct include_guard *) *slot;
+
+  fprintf ((FILE *) f, "G %lu %lu %lu %s %s\n",
+	   (unsigned long) guard->mtime, (unsigned long) guard->size,
+	   (unsigned long) guard->ino, guard->macro, guard->key);
+
+  return 1;
+}
+
+/* If the include cache knows the controlling macro of FILE, which has
+   not been read yet, and FILE has not changed since, set FILE->cmacro
+   to it.  Only a macro that is already defined is looked up, since
+   otherwise FILE must be read anyway and its guard will be found
+   then.  */
+
+static void
+include_cache_find_guard (cpp_reader *pfile, _cpp_file *file)
+{
+  struct include_cache *cache = pfile->include_cache;
+  struct include_guard *guard;
+  cpp_hashnode *node;
+  char *key;
+
+  if (file->path[0] == '\0' || CPP_OPTION (pfile, print_include_names)
+      || !CPP_OPTION (pfile, include_cache_guards))
+    return;
+
+  if (cache == NULL)
+    cache = read_include_cache (pfile);
+
+  key = include_cache_key (file->path);
+  guard = (struct include_guard *)
+    htab_find_with_hash (cache->guards, key, htab_hash_string (key));
+  free (key);
+
+  if (guard == NULL
+      || guard->mtime != file->st.st_mtime
+      || guard->size != file->st.st_size
+      || guard->ino != file->st.st_ino)
+    return;
+
+  node = CPP_HASHNODE (ht_lookup (pfile->hash_table,
+				  (const unsigned char *) guard->macro,
+				  strlen (guard->macro), HT_NO_INSERT));
+  if (node && node->type == NT_MACRO)
+    file->cmacro = node;
+}
+
+/* Record the controlling macro of FILE, just found, in the include
+   cache.  As with directory listings, a file modified in the current
+   second is not recorded.  */
+
+static void
+include_cache_record_guard (cpp_reader *pfile, _cpp_file *file)
+{
+  struct include_cache *cache = pfile->include_cache;
+  struct include_guard *guard;
+  const char *macro = (const char *) NODE_NAME (file->cmacro);
+  char *key;
+  void **slot;
+
+  if (file->path[0] == '\0' || file->st.st_mtime >= time (NULL)
+      || strchr (file->path, '\n'))
+    return;
+
+  if (cache == NULL)
+    cache = read_include_cache (pfile);
+
+  key = include_cache_key (file->path);
+  slot = htab_find_slot_with_hash (cache->guards, key,
+				   htab_hash_string (key), INSERT);
+  guard = (struct include_guard *) *slot;
+  if (guard
+      && guard->mtime == file->st.st_mtime
+      && guard->size == file->st.st_size
+      && guard->ino == file->st.st_ino
+      && !strcmp (guard->macro, macro))
+    {
+      free (key);
+      return;
+    }
+
+  if (guard)
+    {
+      free ((void *) guard->key);
+      free ((void *) guard->macro);
+    }
+  else
+    guard = XNEW (struct include_guard);
+  guard->key = key;
+  guard->macro = xstrdup (macro);
+  guard->mtime = file->st.st_mtime;
+  guard->size = file->st.st_size;
+  guard->ino = file->st.st_ino;
+  *slot = guard;
+  cache->dirty = true;
+}
+
+/* Write the include cache back to its file if anything changed.
+   The new contents go to a temporary file which is then renamed over
+   the old one, so concurrent compilations always read a complete
+   cache; if two of them update it at once, one set of changes is
+   lost, which only costs a later rescan.  The temporary file has to
+   be in the same directory for the rename to work, so it is not made
+   with make_temp_file; a name left behind by a compilation that
+   crashed is skipped.  */
+
+void
+_cpp_write_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+  const char *fname = CPP_OPTION (pfile, include_cache_file);
+  char *tmpname;
+  FILE *f;
+  int fd, attempt;
+  bool ok;
+
+  if (cache == NULL || !cache->dirty)
+    return;
+  cache->dirty = false;
+
+  tmpname = XNEWVEC (char, strlen (fname) + 48);
+  for (attempt = 0; ; attempt++)
+    {
+      sprintf (tmpname, "%s.%ld.%d", fname, (long) getpid (), attempt);
+      fd = open (tmpname, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0666);
+      if (fd != -1 || errno != EEXIST || attempt == 100)
+	break;
+    }
+  f = fd == -1 ? NULL : fdopen (fd, "wb");
+  if (f == NULL)
+    {
+      if (fd != -1)
+	close (fd);
+      cpp_errno (pfile, CPP_DL_WARNING, tmpname);
+      free (tmpname);
+      return;
+    }
+
+  fputs (include_cache_magic, f);
+  htab_traverse (cache->listings, write_dir_listing, f);
+  htab_traverse (cache->guards, write_include_guard, f);
+  ok = !ferror (f);
+  if (fclose (f) != 0)
+    ok = false;
+  if (!ok || rename (tmpname, fname) != 0)
+    {
+      cpp_errno (pfile, CPP_DL_WARNING, fname);
+      unlink (tmpname);
+    }
+
+  free (tmpname);
+}
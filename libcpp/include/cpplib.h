@@ -417,6 +417,17 @@ struct cpp_options
   /* True if dependencies should be restored from a precompiled header.  */
   bool restore_pch_deps;
 
+  /* If nonnull, the file in which listings of the include directories
+     and the controlling macros of headers are cached between
+     compilations, to avoid probing for headers that are not there and
+     reading guarded headers that would be skipped.  */
+  const char *include_cache_file;
+
+  /* True if a header not yet read may be skipped because the include
+     cache says its guard is defined.  Such a header has no linemarkers,
+     so this is turned off when preprocessed text is written.  */
+  bool include_cache_guards;
+
   /* Dependency generation.  */
   struct
   {
@@ -541,6 +552,10 @@ struct cpp_dir
      directories in the search path.  */
   ino_t ino;
   dev_t dev;
+
+  /* The listing of this directory in the include cache, or NULL if
+     it hasn't been looked up yet.  */
+  struct dir_listing *listing;
 };
 
 /* Name under which this program was invoked.  */
@@ -910,6 +925,9 @@ extern cpp_hashnode *cpp_lookup (cpp_reader *, const unsigned char *,
 typedef int (*cpp_cb) (cpp_reader *, cpp_hashnode *, void *);
 extern void cpp_forall_identifiers (cpp_reader *, cpp_cb, void *);
 
+/* In directives-only.c */
+extern void cpp_scan_directives_only (cpp_reader *);
+
 /* In macro.c */
 extern void cpp_scan_nooutput (cpp_reader *);
 extern int  cpp_sys_macro_p (cpp_reader *);
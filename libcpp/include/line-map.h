@@ -70,6 +70,14 @@ struct line_map GTY(())
   unsigned int column_bits : 8;
 };
 
+/* The number of recently used maps, besides the most recent one,
+   that linemap_lookup tries before searching.  */
+#define LINEMAP_LOOKUP_CACHE_SIZE 8
+
+/* The number of column bits a line_maps with PACK_COLUMNS set gives
+   at most to a line.  */
+#define LINEMAP_PACKED_COLUMN_BITS 12
+
 /* A set of chronological line_map structures.  */
 struct line_maps GTY(())
 {
@@ -77,8 +85,14 @@ struct line_maps GTY(())
   unsigned int allocated;
   unsigned int used;
 
+  /* The index of the map most recently returned by linemap_lookup.  */
   unsigned int cache;
 
+  /* The indices of other maps recently returned by linemap_lookup,
+     and the entry to be replaced next.  */
+  unsigned int lookup_cache[LINEMAP_LOOKUP_CACHE_SIZE];
+  unsigned int lookup_cache_next;
+
   /* The most recently listed include stack, if any, starts with
      LAST_LISTED as the topmost including file.  -1 indicates nothing
      has been listed yet.  */
@@ -90,6 +104,12 @@ struct line_maps GTY(())
   /* If true, prints an include trace a la -H.  */
   bool trace_includes;
 
+  /* If true, column numbers get at most LINEMAP_PACKED_COLUMN_BITS
+     bits, higher columns being recorded as the highest one that
+     fits, and a map is not split just to give later lines fewer
+     column bits.  Long generated lines then need no new maps.  */
+  bool pack_columns;
+
   /* Highest source_location "given out".  */
   source_location highest_location;
 
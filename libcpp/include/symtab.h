@@ -80,8 +80,65 @@ extern hashnode ht_lookup (hash_table *, const unsigned char *,
 extern hashnode ht_lookup_with_hash (hash_table *, const unsigned char *,
                                      size_t, unsigned int,
                                      enum ht_lookup_option);
-#define HT_HASHSTEP(r, c) ((r) * 67 + ((c) - 113));
-#define HT_HASHFINISH(r, len) ((r) + (len))
+
+/* Multiplier for the hash steps; an odd constant with well mixed
+   bits.  */
+#define HT_MULTIPLIER 0x9e3779b1U
+
+/* Fold the word W into the running hash R.  */
+#define HT_HASHWORD(r, w) \
+  ((((r) << 5 | (r) >> (sizeof (unsigned int) * CHAR_BIT - 5)) ^ (w)) \
+   * HT_MULTIPLIER)
+
+/* The hash of a string is built a byte at a time, so that the lexer
+   can compute it while it scans an identifier.  The state is the
+   running hash R, the word W being filled and the number N of bytes
+   in it, all starting at zero.  HT_HASHSTEP adds the byte C, folding
+   W into R whenever it fills up.  */
+#define HT_HASHSTEP(r, w, n, c)				\
+  do							\
+    {							\
+      (w) |= (unsigned int) (c) << ((n) * CHAR_BIT);	\
+      if (++(n) == sizeof (unsigned int))		\
+	{						\
+	  (r) = HT_HASHWORD (r, w);			\
+	  (w) = 0;					\
+	  (n) = 0;					\
+	}						\
+    }							\
+  while (0)
+
+/* Finish the hash of a string of length LEN from the state R and W
+   left by HT_HASHSTEP.  The last word, padded with zeros, is folded in
+   together with the length, and the result mixed so that all of its
+   bits, in particular the low ones used for the table index, depend
+   on every input byte.  */
+
+static inline unsigned int
+ht_hash_finish (unsigned int r, unsigned int w, size_t len)
+{
+  r = HT_HASHWORD (r ^ (unsigned int) len, w);
+
+  r ^= r >> 15;
+  r *= 0x85ebca6bU;
+  r ^= r >> 13;
+
+  return r;
+}
+
+/* Calculate the hash of the string STR of length LEN.  */
+
+static inline unsigned int
+ht_calc_hash (const unsigned char *str, size_t len)
+{
+  unsigned int r = 0, w = 0, n = 0;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    HT_HASHSTEP (r, w, n, str[i]);
+
+  return ht_hash_finish (r, w, len);
+}
 
 /* For all nodes in TABLE, make a callback.  The callback takes
    TABLE->PFILE, the node, and a PTR, and the callback sequence stops
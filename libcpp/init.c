@@ -132,6 +132,9 @@ init_library (void)
 	 initializers.  */
       init_trigraph_map ();
 
+      /* Choose the fastest line scanner for this CPU.  */
+      _cpp_init_lexer ();
+
 #ifdef ENABLE_NLS
        (void) bindtextdomain (PACKAGE, LOCALEDIR);
 #endif
@@ -166,6 +169,7 @@ cpp_create_reader (enum c_lang lang, hash_table *table,
   CPP_OPTION (pfile, warn_variadic_macros) = 1;
   CPP_OPTION (pfile, warn_builtin_macro_redefined) = 1;
   CPP_OPTION (pfile, warn_normalize) = normalized_C;
+  CPP_OPTION (pfile, include_cache_guards) = 1;
 
   /* Default CPP arithmetic to something sensible for the host for the
      benefit of dumb users like fix-header.  */
@@ -224,6 +228,15 @@ cpp_create_reader (enum c_lang lang, hash_table *table,
 		  (void *(*) (long)) xmalloc,
 		  (void (*) (void *)) free);
 
+  /* Initialize the obstacks for memoized macro expansions.  */
+  _obstack_begin (&pfile->expansion_obs[0], 0, 0,
+		  (void *(*) (long)) xmalloc,
+		  (void (*) (void *)) free);
+  _obstack_begin (&pfile->expansion_obs[1], 0, 0,
+		  (void *(*) (long)) xmalloc,
+		  (void (*) (void *)) free);
+  pfile->expansion_ob = &pfile->expansion_obs[0];
+
   _cpp_init_files (pfile);
 
   _cpp_init_hashtable (pfile, table);
@@ -266,6 +279,7 @@ cpp_destroy (cpp_reader *pfile)
   if (pfile->deps)
     deps_free (pfile->deps);
   obstack_free (&pfile->buffer_ob, 0);
+  _cpp_destroy_expansion_cache (pfile);
 
   _cpp_destroy_hashtable (pfile);
   _cpp_cleanup_files (pfile);
@@ -403,6 +417,7 @@ cpp_init_special_builtins (cpp_reader *pfile)
 	hp->flags |= NODE_WARN;
       hp->value.builtin = (enum builtin_type) b->value;
     }
+  _cpp_macro_changed (pfile, NULL);
 }
 
 /* Read the builtins table above and enter them, and language-specific
@@ -650,6 +665,9 @@ cpp_finish (cpp_reader *pfile, FILE *deps_stream)
   if (CPP_OPTION (pfile, print_include_names))
     _cpp_report_missing_guards (pfile);
 
+  if (CPP_OPTION (pfile, include_cache_file))
+    _cpp_write_include_cache (pfile);
+
   return pfile->errors;
 }
 
@@ -305,6 +305,14 @@ struct cpp_buffer
   struct cset_converter input_cset_desc;
 };
 
+/* A summary of the macros defined at some point: their number, and
+   the sum of the hashes of their definitions.  Builtins are left out.  */
+struct cpp_macro_fingerprint
+{
+  unsigned int n_defs;
+  unsigned int hash;
+};
+
 /* A cpp_reader encapsulates the "state" of a pre-processor run.
    Applying cpp_get_token repeatedly yields a stream of pre-processor
    tokens.  Usually, there is only one cpp_reader object active.  */
@@ -367,6 +375,10 @@ struct cpp_reader
   struct htab *nonexistent_file_hash;
   struct obstack nonexistent_file_ob;
 
+  /* Include directory listings cached across compilations, or NULL
+     if not yet read.  */
+  struct include_cache *include_cache;
+
   /* Nonzero means don't look for #include "foo" the source-file
      directory.  */
   bool quote_ignores_source_dir;
@@ -430,6 +442,17 @@ struct cpp_reader
      real stack.  See directives.c.  */
   struct obstack buffer_ob;
 
+  /* Memoized expansions of object-like macros, keyed by node.  Their
+     tokens are on EXPANSION_OB, which points to one of EXPANSION_OBS;
+     flushing the table empties and switches to the other one.  See
+     macro.c.  */
+  struct htab *expansion_cache;
+  struct obstack expansion_obs[2];
+  struct obstack *expansion_ob;
+
+  /* Bumped by every change to a macro definition.  */
+  unsigned int macro_generation;
+
   /* Pragma table - dynamic, because a library user can add to the
      list of recognized pragmas.  */
   struct pragma_entry *pragmas;
@@ -469,6 +492,14 @@ struct cpp_reader
      of precompiled headers.  */
   struct cpp_savedstate *savedstate;
 
+  /* A summary of the macros currently defined, against which
+     precompiled headers are checked.  It is up to date while
+     FINGERPRINT_VALID and FINGERPRINT_GENERATION equals
+     MACRO_GENERATION.  See pch.c.  */
+  struct cpp_macro_fingerprint fingerprint;
+  unsigned int fingerprint_generation;
+  bool fingerprint_valid;
+
   /* Next value of __COUNTER__ macro. */
   unsigned int counter;
 
@@ -536,11 +567,19 @@ extern int _cpp_warn_if_unused_macro (cpp_reader *, cpp_hashnode *, void *);
 extern void _cpp_push_token_context (cpp_reader *, cpp_hashnode *,
 				     const cpp_token *, unsigned int);
 extern void _cpp_backup_tokens_direct (cpp_reader *, unsigned int);
+extern void _cpp_macro_changed (cpp_reader *, cpp_hashnode *);
+extern void _cpp_destroy_expansion_cache (cpp_reader *);
 
 /* In identifiers.c */
 extern void _cpp_init_hashtable (cpp_reader *, hash_table *);
 extern void _cpp_destroy_hashtable (cpp_reader *);
 
+/* Number of bytes that must be allocated after the contents of a file
+   buffer.  _cpp_convert_input stores the terminating newline in the
+   first; the rest keep the aligned 16-byte reads of the fast line
+   scanner in _cpp_clean_line within the allocation.  */
+#define CPP_BUFFER_PADDING 16
+
 /* In files.c */
 typedef struct _cpp_file _cpp_file;
 extern _cpp_file *_cpp_find_file (cpp_reader *, const char *, cpp_dir *,
@@ -556,6 +595,7 @@ extern void _cpp_report_missing_guards (cpp_reader *);
 extern void _cpp_init_files (cpp_reader *);
 extern void _cpp_cleanup_files (cpp_reader *);
 extern void _cpp_pop_file_buffer (cpp_reader *, struct _cpp_file *);
+extern void _cpp_write_include_cache (cpp_reader *);
 extern bool _cpp_save_file_entries (cpp_reader *pfile, FILE *f);
 extern bool _cpp_read_file_entries (cpp_reader *, FILE *);
 extern struct stat *_cpp_get_file_stat (_cpp_file *);
@@ -565,6 +605,7 @@ extern bool _cpp_parse_expr (cpp_reader *, bool);
 extern struct op *_cpp_expand_op_stack (cpp_reader *);
 
 /* In lex.c */
+extern void _cpp_init_lexer (void);
 extern void _cpp_process_line_notes (cpp_reader *, int);
 extern void _cpp_clean_line (cpp_reader *);
 extern bool _cpp_get_fresh_line (cpp_reader *);
@@ -645,6 +686,7 @@ extern void _cpp_destroy_iconv (cpp_reader *);
 extern unsigned char *_cpp_convert_input (cpp_reader *, const char *,
 					  unsigned char *, size_t, size_t,
 					  const unsigned char **, off_t *);
+extern bool _cpp_input_charset_identity_p (const char *);
 extern const char *_cpp_default_encoding (void);
 extern cpp_hashnode * _cpp_interpret_identifier (cpp_reader *pfile,
 						 const unsigned char *id,
@@ -96,6 +96,154 @@ add_line_note (cpp_buffer *buffer, const uchar *pos, unsigned int type)
   buffer->notes_used++;
 }
 
+/* Fast scanners used by _cpp_clean_line.  Each returns a pointer to
+   the first '\n', '\r', '\\' or '?' at or after S.  The buffer is
+   guaranteed to contain a terminating newline, so no end pointer is
+   needed.  The scanners may read whole aligned words or vectors that
+   straddle the terminator; such reads never cross a page boundary,
+   and CPP_BUFFER_PADDING keeps them within allocated memory.  */
+
+typedef const uchar *(*search_line_fn) (const uchar *);
+
+/* Return true if C is one of the characters _cpp_clean_line stops at.  */
+#define clean_line_special_p(c) \
+  ((c) == '\n' || (c) == '\r' || (c) == '\\' || (c) == '?')
+
+/* The word-at-a-time scanner, usable on any host.  Each word is tested
+   for the four characters at once: after XORing with a replicated
+   character, a byte that was equal to it becomes zero, and the usual
+   carry trick detects a zero byte.  False positives are possible, so
+   the candidate word is then checked byte by byte.  */
+
+typedef unsigned long search_word;
+
+static const uchar *
+search_line_acc_char (const uchar *s)
+{
+  const search_word ones = (search_word) -1 / 0xff;
+  const search_word highs = ones << 7;
+  const search_word repl_nl = ones * '\n';
+  const search_word repl_cr = ones * '\r';
+  const search_word repl_bs = ones * '\\';
+  const search_word repl_qm = ones * '?';
+  const search_word *p;
+  search_word val, t;
+  unsigned int i;
+
+  /* Scan bytewise up to the first word boundary.  */
+  while ((size_t) s & (sizeof (search_word) - 1))
+    {
+      if (clean_line_special_p (*s))
+	return s;
+      s++;
+    }
+
+  for (p = (const search_word *) s; ; p++)
+    {
+      val = *p;
+      t  = ((val ^ repl_nl) - ones) & ~(val ^ repl_nl);
+      t |= ((val ^ repl_cr) - ones) & ~(val ^ repl_cr);
+      t |= ((val ^ repl_bs) - ones) & ~(val ^ repl_bs);
+      t |= ((val ^ repl_qm) - ones) & ~(val ^ repl_qm);
+
+      if (__builtin_expect ((t & highs) != 0, false))
+	{
+	  s = (const uchar *) p;
+	  for (i = 0; i < sizeof (search_word); i++)
+	    if (clean_line_special_p (s[i]))
+	      return s + i;
+	}
+    }
+}
+
+#if (GCC_VERSION >= 4004) && (defined (__i386__) || defined (__x86_64__))
+
+/* The SSE2 scanner, processing 16 bytes at a time.  On i386 it is
+   compiled for SSE2 even if the rest of the library isn't, and only
+   used if the CPU supports it.  */
+
+static const char repl_chars[4][16] __attribute__((aligned(16))) = {
+  { '\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n',
+    '\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n' },
+  { '\r', '\r', '\r', '\r', '\r', '\r', '\r', '\r',
+    '\r', '\r', '\r', '\r', '\r', '\r', '\r', '\r' },
+  { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\',
+    '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' },
+  { '?', '?', '?', '?', '?', '?', '?', '?',
+    '?', '?', '?', '?', '?', '?', '?', '?' },
+};
+
+static const uchar *
+#ifndef __SSE2__
+__attribute__((__target__("sse2")))
+#endif
+search_line_sse2 (const uchar *s)
+{
+  typedef char v16qi __attribute__ ((__vector_size__ (16)));
+
+  const v16qi repl_nl = *(const v16qi *) repl_chars[0];
+  const v16qi repl_cr = *(const v16qi *) repl_chars[1];
+  const v16qi repl_bs = *(const v16qi *) repl_chars[2];
+  const v16qi repl_qm = *(const v16qi *) repl_chars[3];
+
+  unsigned int misalign, found, mask;
+  const v16qi *p;
+  v16qi data, t;
+
+  /* Align the source pointer, and ignore the bytes of the first block
+     that lie before S.  */
+  misalign = (size_t) s & 15;
+  p = (const v16qi *) ((size_t) s & -16);
+  data = *p;
+  mask = -1u << misalign;
+
+  goto start;
+  do
+    {
+      data = *++p;
+      mask = -1;
+
+    start:
+      t  = __builtin_ia32_pcmpeqb128 (data, repl_nl);
+      t |= __builtin_ia32_pcmpeqb128 (data, repl_cr);
+      t |= __builtin_ia32_pcmpeqb128 (data, repl_bs);
+      t |= __builtin_ia32_pcmpeqb128 (data, repl_qm);
+      found = __builtin_ia32_pmovmskb128 (t) & mask;
+    }
+  while (!found);
+
+  return (const uchar *) p + __builtin_ctz (found);
+}
+
+#include "../gcc/config/i386/cpuid.h"
+
+static search_line_fn search_line_fast = search_line_acc_char;
+
+/* Select the SSE2 scanner if the CPU supports it.  */
+void
+_cpp_init_lexer (void)
+{
+#ifdef __SSE2__
+  search_line_fast = search_line_sse2;
+#else
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid (1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2))
+    search_line_fast = search_line_sse2;
+#endif
+}
+
+#else
+
+#define search_line_fast search_line_acc_char
+
+void
+_cpp_init_lexer (void)
+{
+}
+
+#endif
+
 /* Returns with a logical line that contains no escaped newlines or
    trigraphs.  This is a time-critical inner loop.  */
 void
@@ -118,65 +266,71 @@ _cpp_clean_line (cpp_reader *pfile)
       /* Short circuit for the common case of an un-escaped line with
 	 no trigraphs.  The primary win here is by not writing any
 	 data back to memory until we have to.  */
+      s++;
       for (;;)
 	{
-	  c = *++s;
-	  if (__builtin_expect (c == '\n', false)
-	      || __builtin_expect (c == '\r', false))
-	    {
-	      d = (uchar *) s;
-
-	      if (__builtin_expect (s == buffer->rlimit, false))
-		goto done;
+	  /* Skip ahead to the next \n, \r, \\ or ?.  */
+	  s = search_line_fast (s);
 
-	      /* DOS line ending? */
-	      if (__builtin_expect (c == '\r', false)
-		  && s[1] == '\n')
+	  c = *s;
+	  if (c == '\\')
+	    pbackslash = s++;
+	  else if (__builtin_expect (c == '?', false))
+	    {
+	      if (__builtin_expect (s[1] == '?', false)
+		  && _cpp_trigraph_map[s[2]])
 		{
-		  s++;
-		  if (s == buffer->rlimit)
-		    goto done;
+		  /* Have a trigraph.  We may or may not have to convert
+		     it.  Add a line note regardless, for -Wtrigraphs.  */
+		  add_line_note (buffer, s, s[2]);
+		  if (CPP_OPTION (pfile, trigraphs))
+		    {
+		      /* We do, and that means we have to switch to the
+			 slow path.  */
+		      d = (uchar *) s;
+		      *d = _cpp_trigraph_map[s[2]];
+		      s += 2;
+		      goto slow_path;
+		    }
 		}
+	      s++;
+	    }
+	  else
+	    break;
+	}
 
-	      if (__builtin_expect (pbackslash == NULL, true))
-		goto done;
+      /* This must be \n or \r.  */
+      d = (uchar *) s;
 
-	      /* Check for escaped newline.  */
-	      p = d;
-	      while (is_nvspace (p[-1]))
-		p--;
-	      if (p - 1 != pbackslash)
-		goto done;
+      if (__builtin_expect (s == buffer->rlimit, false))
+	goto done;
 
-	      /* Have an escaped newline; process it and proceed to
-		 the slow path.  */
-	      add_line_note (buffer, p - 1, p != d ? ' ' : '\\');
-	      d = p - 2;
-	      buffer->next_line = p - 1;
-	      break;
-	    }
-	  if (__builtin_expect (c == '\\', false))
-	    pbackslash = s;
-	  else if (__builtin_expect (c == '?', false)
-		   && __builtin_expect (s[1] == '?', false)
-		   && _cpp_trigraph_map[s[2]])
-	    {
-	      /* Have a trigraph.  We may or may not have to convert
-		 it.  Add a line note regardless, for -Wtrigraphs.  */
-	      add_line_note (buffer, s, s[2]);
-	      if (CPP_OPTION (pfile, trigraphs))
-		{
-		  /* We do, and that means we have to switch to the
-		     slow path.  */
-		  d = (uchar *) s;
-		  *d = _cpp_trigraph_map[s[2]];
-		  s += 2;
-		  break;
-		}
-	    }
+      /* DOS line ending? */
+      if (__builtin_expect (c == '\r', false)
+	  && s[1] == '\n')
+	{
+	  s++;
+	  if (s == buffer->rlimit)
+	    goto done;
 	}
 
+      if (__builtin_expect (pbackslash == NULL, true))
+	goto done;
+
+      /* Check for escaped newline.  */
+      p = d;
+      while (is_nvspace (p[-1]))
+	p--;
+      if (p - 1 != pbackslash)
+	goto done;
+
+      /* Have an escaped newline; process it and proceed to
+	 the slow path.  */
+      add_line_note (buffer, p - 1, p != d ? ' ' : '\\');
+      d = p - 2;
+      buffer->next_line = p - 1;
 
+    slow_path:
       for (;;)
 	{
 	  c = *++s;
@@ -226,7 +380,10 @@ _cpp_clean_line (cpp_reader *pfile)
     }
 
  done:
-  *d = '\n';
+  /* Avoid dirtying the buffer needlessly; it may be a private mapping
+     of the file.  */
+  if (*d != '\n')
+    *d = '\n';
   /* A sentinel note that should never be processed.  */
   add_line_note (buffer, d + 1, '\n');
   buffer->next_line = s + 1;
@@ -512,13 +669,14 @@ lex_identifier (cpp_reader *pfile, const uchar *base, bool starts_ucn,
   cpp_hashnode *result;
   const uchar *cur;
   unsigned int len;
-  unsigned int hash = HT_HASHSTEP (0, *base);
+  unsigned int hash = 0, word = 0, nbytes = 0;
 
+  HT_HASHSTEP (hash, word, nbytes, *base);
   cur = pfile->buffer->cur;
   if (! starts_ucn)
     while (ISIDNUM (*cur))
       {
-	hash = HT_HASHSTEP (hash, *cur);
+	HT_HASHSTEP (hash, word, nbytes, *cur);
 	cur++;
       }
   pfile->buffer->cur = cur;
@@ -538,7 +696,7 @@ lex_identifier (cpp_reader *pfile, const uchar *base, bool starts_ucn,
   else
     {
       len = cur - base;
-      hash = HT_HASHFINISH (hash, len);
+      hash = ht_hash_finish (hash, word, len);
 
       result = CPP_HASHNODE (ht_lookup_with_hash (pfile->hash_table,
 						  base, len, hash, HT_ALLOC));
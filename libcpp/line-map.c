@@ -36,8 +36,11 @@ linemap_init (struct line_maps *set)
   set->used = 0;
   set->last_listed = -1;
   set->trace_includes = false;
+  set->pack_columns = false;
   set->depth = 0;
   set->cache = 0;
+  memset (set->lookup_cache, 0, sizeof (set->lookup_cache));
+  set->lookup_cache_next = 0;
   set->highest_location = 0;
   set->highest_line = 0;
   set->max_column_hint = 0;
@@ -191,10 +194,14 @@ linemap_line_start (struct line_maps *set, linenum_type to_line,
   linenum_type last_line = SOURCE_LINE (map, set->highest_line);
   int line_delta = to_line - last_line;
   bool add_map = false;
+  if (set->pack_columns
+      && max_column_hint >= (1U << LINEMAP_PACKED_COLUMN_BITS))
+    max_column_hint = (1U << LINEMAP_PACKED_COLUMN_BITS) - 1;
   if (line_delta < 0
       || (line_delta > 10 && line_delta * map->column_bits > 1000)
       || (max_column_hint >= (1U << map->column_bits))
-      || (max_column_hint <= 80 && map->column_bits >= 10))
+      || (max_column_hint <= 80 && map->column_bits >= 10
+	  && !set->pack_columns))
     {
       add_map = true;
     }
@@ -243,6 +250,9 @@ source_location
 linemap_position_for_column (struct line_maps *set, unsigned int to_column)
 {
   source_location r = set->highest_line;
+  if (set->pack_columns
+      && to_column >= (1U << LINEMAP_PACKED_COLUMN_BITS))
+    to_column = (1U << LINEMAP_PACKED_COLUMN_BITS) - 1;
   if (to_column >= set->max_column_hint)
     {
       if (r >= 0xC000000 || to_column > 100000)
@@ -265,12 +275,14 @@ linemap_position_for_column (struct line_maps *set, unsigned int to_column)
 /* Given a logical line, returns the map from which the corresponding
    (source file, line) pair can be deduced.  Since the set is built
    chronologically, the logical lines are monotonic increasing, and so
-   the list is sorted and we can use a binary search.  */
+   the list is sorted and we can use a binary search.  Callers such as
+   debug info output alternate between a few maps far apart in the
+   set, so the maps recently returned are tried first.  */
 
 const struct line_map *
 linemap_lookup (struct line_maps *set, source_location line)
 {
-  unsigned int md, mn, mx;
+  unsigned int md, mn, mx, i;
   const struct line_map *cached;
 
   mn = set->cache;
@@ -289,6 +301,19 @@ linemap_lookup (struct line_maps *set, source_location line)
       mn = 0;
     }
 
+  for (i = 0; i < LINEMAP_LOOKUP_CACHE_SIZE; i++)
+    {
+      md = set->lookup_cache[i];
+      if (md < set->used
+	  && line >= set->maps[md].start_location
+	  && (md + 1 == set->used || line < set->maps[md + 1].start_location))
+	{
+	  set->lookup_cache[i] = set->cache;
+	  set->cache = md;
+	  return &set->maps[md];
+	}
+    }
+
   while (mx - mn > 1)
     {
       md = (mn + mx) / 2;
@@ -298,6 +323,9 @@ linemap_lookup (struct line_maps *set, source_location line)
 	mn = md;
     }
 
+  set->lookup_cache[set->lookup_cache_next] = set->cache;
+  set->lookup_cache_next
+    = (set->lookup_cache_next + 1) % LINEMAP_LOOKUP_CACHE_SIZE;
   set->cache = mn;
   return &set->maps[mn];
 }
@@ -28,6 +28,7 @@ along with this program; see the file COPYING3.  If not see
 #include "system.h"
 #include "cpplib.h"
 #include "internal.h"
+#include "hashtab.h"
 
 typedef struct macro_arg macro_arg;
 struct macro_arg
@@ -1188,6 +1189,329 @@ _cpp_pop_context (cpp_reader *pfile)
   pfile->context = context->prev;
 }
 
+/* Memoized expansion of object-like macros.
+
+   An object-like macro whose replacement list names only other
+   object-like macros expands to the same tokens every time, for as
+   long as none of the names involved changes its definition.  Once
+   such a macro has been expanded from the base context a second time,
+   its complete expansion is recorded, and later expansions push the
+   recorded tokens as a single context rather than re-entering every
+   nested macro.
+
+   Each name met while examining an expansion, whether a macro or not,
+   keeps a list of the entries that examined it, and changing its
+   definition resets just those entries.  */
+
+/* The most replacement tokens examined for one memoized expansion.  */
+#define EXPANSION_CACHE_MAX_TOKENS 256
+
+/* The cache is flushed once this many bytes hold recorded tokens.  */
+#define EXPANSION_CACHE_MAX_BYTES (16 * 1024 * 1024)
+
+struct expansion_dep;
+
+struct expansion_entry
+{
+  cpp_hashnode *node;
+
+  /* The recorded expansion, or NULL if not recorded yet.  */
+  const cpp_token *tokens;
+  unsigned int count;
+
+  /* Number of times NODE has been expanded without being recorded.  */
+  unsigned int uses;
+
+  /* Bumped each time the fields above are reset.  */
+  unsigned int version;
+
+  /* True if NODE's expansion is not to be recorded.  */
+  bool uncacheable;
+
+  /* The entries that examined NODE when deciding whether to record
+     their expansion.  */
+  struct expansion_dep *dependents;
+};
+
+/* A note that ENTRY, at version VERSION, depends on the definition of
+   some name.  Notes made before ENTRY was last reset are ignored.  */
+struct expansion_dep
+{
+  struct expansion_entry *entry;
+  unsigned int version;
+  struct expansion_dep *next;
+};
+
+static hashval_t
+hash_expansion_entry (const void *p)
+{
+  return htab_hash_pointer (((const struct expansion_entry *) p)->node);
+}
+
+static int
+eq_expansion_entry (const void *p, const void *q)
+{
+  return ((const struct expansion_entry *) p)->node == q;
+}
+
+/* Return the memoized state of NODE, creating it if INSERT.  */
+static struct expansion_entry *
+lookup_expansion_entry (cpp_reader *pfile, cpp_hashnode *node,
+			enum insert_option insert)
+{
+  struct expansion_entry *entry;
+  void **slot;
+
+  slot = htab_find_slot_with_hash (pfile->expansion_cache, node,
+				   htab_hash_pointer (node), insert);
+  if (slot == NULL)
+    return NULL;
+
+  entry = (struct expansion_entry *) *slot;
+  if (entry == NULL)
+    {
+      entry = XCNEW (struct expansion_entry);
+      entry->node = node;
+      *slot = entry;
+    }
+  return entry;
+}
+
+/* Note that ENTRY depends on the definition of NODE.  */
+static void
+add_expansion_dep (cpp_reader *pfile, struct expansion_entry *entry,
+		   cpp_hashnode *node)
+{
+  struct expansion_entry *dep_entry;
+  struct expansion_dep *dep;
+
+  dep_entry = lookup_expansion_entry (pfile, node, INSERT);
+  dep = dep_entry->dependents;
+  if (dep && dep->entry == entry && dep->version == entry->version)
+    return;
+
+  dep = XOBNEW (pfile->expansion_ob, struct expansion_dep);
+  dep->entry = entry;
+  dep->version = entry->version;
+  dep->next = dep_entry->dependents;
+  dep_entry->dependents = dep;
+}
+
+/* Forget what was memoized about the expansion of ENTRY.  */
+static void
+reset_expansion_entry (struct expansion_entry *entry)
+{
+  entry->tokens = NULL;
+  entry->count = 0;
+  entry->uses = 0;
+  entry->uncacheable = false;
+  entry->version++;
+}
+
+/* Empty the cache.  The tokens recorded before the previous flush are
+   freed, and those recorded since are kept until the next one, since
+   the client may still refer to the last few tokens it was given.  */
+static void
+flush_expansion_cache (cpp_reader *pfile)
+{
+  struct obstack *ob;
+
+  htab_empty (pfile->expansion_cache);
+
+  ob = (pfile->expansion_ob == &pfile->expansion_obs[0]
+	? &pfile->expansion_obs[1] : &pfile->expansion_obs[0]);
+  obstack_free (ob, 0);
+  _obstack_begin (ob, 0, 0,
+		  (void *(*) (long)) xmalloc,
+		  (void (*) (void *)) free);
+  pfile->expansion_ob = ob;
+}
+
+/* Returns true if expanding NODE only ever enters object-like macros,
+   and so always yields the same tokens, none of them the name of a
+   macro that is disabled at that point.  Every name examined is noted
+   as a dependency of ENTRY.  *BUDGET is the number of replacement
+   tokens that may still be examined; *NESTED is set if NODE's
+   expansion enters any other macro.  Macros being examined are
+   disabled, just as they are while being expanded.  */
+static bool
+expansion_cacheable_p (cpp_reader *pfile, struct expansion_entry *entry,
+		       cpp_hashnode *node, unsigned int *budget, bool *nested)
+{
+  cpp_macro *macro;
+  unsigned int i;
+  bool ok = true;
+
+  if (node->flags & (NODE_BUILTIN | NODE_CONDITIONAL))
+    return false;
+
+  macro = node->value.macro;
+  if (macro->fun_like || macro->count > *budget)
+    return false;
+  *budget -= macro->count;
+
+  node->flags |= NODE_DISABLED;
+  for (i = 0; ok && i < macro->count; i++)
+    {
+      const cpp_token *token = &macro->exp.tokens[i];
+
+      if (token->flags & PASTE_LEFT)
+	ok = false;
+      else if (token->type == CPP_NAME)
+	{
+	  add_expansion_dep (pfile, entry, token->val.node);
+	  if (token->val.node->type != NT_MACRO)
+	    continue;
+
+	  /* The name of a disabled macro is returned as a copy located
+	     at the invocation, which differs between expansions.  */
+	  if (token->val.node->flags & NODE_DISABLED)
+	    ok = false;
+	  else
+	    {
+	      *nested = true;
+	      ok = expansion_cacheable_p (pfile, entry, token->val.node,
+					  budget, nested);
+	    }
+	}
+    }
+  node->flags &= ~NODE_DISABLED;
+
+  return ok;
+}
+
+/* Expand the macro named by RESULT in the usual way, recording the
+   tokens it produces in ENTRY.  The name is fed through a context of
+   its own, terminated by a CPP_EOF like a macro argument.  The first
+   token returned is the padding for RESULT and the last the paste
+   avoidance from popping the macro's context; replaying reproduces
+   both, so only the tokens in between are recorded.  */
+static void
+record_expansion (cpp_reader *pfile, struct expansion_entry *entry,
+		  const cpp_token *result)
+{
+  const cpp_token *sentinel[2];
+  const cpp_token *token, *prev = NULL;
+  unsigned int count = 0;
+
+  sentinel[0] = result;
+  sentinel[1] = &pfile->eof;
+  push_ptoken_context (pfile, NULL, NULL, sentinel, 2);
+
+  cpp_get_token (pfile);
+  while ((token = cpp_get_token (pfile))->type != CPP_EOF)
+    {
+      if (prev)
+	{
+	  obstack_grow (pfile->expansion_ob, prev, sizeof (cpp_token));
+	  count++;
+	}
+      prev = token;
+    }
+
+  _cpp_pop_context (pfile);
+
+  /* Padding tokens keep pointing at their source, which is a token
+     of some macro's replacement list; that stays valid until the
+     macro is redefined, which resets this entry.  */
+  entry->tokens = (const cpp_token *) obstack_finish (pfile->expansion_ob);
+  entry->count = count;
+}
+
+/* Try to expand NODE, an object-like macro named by RESULT in the
+   base context, from its memoized expansion, recording the expansion
+   first if NODE has been expanded before.  Returns 1 if a context was
+   pushed, as enter_macro_context does, and 0 if NODE should be
+   expanded normally.  */
+static int
+enter_cached_expansion (cpp_reader *pfile, cpp_hashnode *node,
+			const cpp_token *result)
+{
+  struct expansion_entry *entry;
+
+  if (pfile->expansion_cache == NULL)
+    pfile->expansion_cache = htab_create (127, hash_expansion_entry,
+					  eq_expansion_entry, free);
+
+  entry = lookup_expansion_entry (pfile, node, INSERT);
+  if (entry->tokens == NULL)
+    {
+      unsigned int budget = EXPANSION_CACHE_MAX_TOKENS;
+      bool nested = false;
+
+      /* A macro expanded just once is not worth recording.  */
+      if (entry->uncacheable || entry->uses++ == 0)
+	return 0;
+
+      /* Start over once the cache is full.  */
+      if (obstack_memory_used (pfile->expansion_ob)
+	  > EXPANSION_CACHE_MAX_BYTES)
+	{
+	  flush_expansion_cache (pfile);
+	  return 0;
+	}
+
+      /* Nor is one that enters no other macro: its replacement list
+	 is already pushed without copying.  */
+      if (!expansion_cacheable_p (pfile, entry, node, &budget, &nested)
+	  || !nested)
+	{
+	  entry->uncacheable = true;
+	  return 0;
+	}
+
+      record_expansion (pfile, entry, result);
+    }
+
+  /* Everything enter_macro_context would have done was done when the
+     expansion was recorded, except for the following.  */
+  pfile->mi_valid = false;
+  pfile->state.angled_headers = false;
+  node->flags |= NODE_DISABLED;
+  _cpp_push_token_context (pfile, node, entry->tokens, entry->count);
+
+  return 1;
+}
+
+/* Note that the definition of NODE changed, or of every macro if NODE
+   is NULL, and forget the memoized expansions that depended on it.  */
+void
+_cpp_macro_changed (cpp_reader *pfile, cpp_hashnode *node)
+{
+  struct expansion_entry *entry;
+  struct expansion_dep *dep;
+
+  pfile->macro_generation++;
+  if (pfile->expansion_cache == NULL)
+    return;
+
+  if (node == NULL)
+    {
+      flush_expansion_cache (pfile);
+      return;
+    }
+
+  entry = lookup_expansion_entry (pfile, node, NO_INSERT);
+  if (entry == NULL)
+    return;
+
+  reset_expansion_entry (entry);
+  for (dep = entry->dependents; dep; dep = dep->next)
+    if (dep->version == dep->entry->version)
+      reset_expansion_entry (dep->entry);
+  entry->dependents = NULL;
+}
+
+/* Frees the memoized expansions.  */
+void
+_cpp_destroy_expansion_cache (cpp_reader *pfile)
+{
+  if (pfile->expansion_cache)
+    htab_delete (pfile->expansion_cache);
+  obstack_free (&pfile->expansion_obs[0], 0);
+  obstack_free (&pfile->expansion_obs[1], 0);
+}
+
 /* External routine to get a token.  Also used nearly everywhere
    internally, except for places where we know we can safely call
    _cpp_lex_token directly, such as lexing a directive name.
@@ -1288,7 +1612,16 @@ cpp_get_token (cpp_reader *pfile)
 		}
 	    }
 	  else
-	    ret = enter_macro_context (pfile, node, result);
+	    {
+	      /* Object-like macros met in the base context may be
+		 replayed from their memoized expansion.  */
+	      if (!context->prev && !pfile->state.in_directive
+		  && !(node->flags & NODE_BUILTIN)
+		  && !node->value.macro->fun_like)
+		ret = enter_cached_expansion (pfile, node, result);
+	      if (!ret)
+		ret = enter_macro_context (pfile, node, result);
+	    }
 	  if (ret)
  	    {
 	      if (pfile->state.in_directive || ret == 2)
@@ -1849,6 +2182,7 @@ _cpp_create_definition (cpp_reader *pfile, cpp_hashnode *node)
   /* Enter definition in hash table.  */
   node->type = NT_MACRO;
   node->value.macro = macro;
+  _cpp_macro_changed (pfile, node);
   if (! ustrncmp (NODE_NAME (node), DSC ("__STDC_"))
       && ustrcmp (NODE_NAME (node), (const uchar *) "__STDC_FORMAT_MACROS")
       /* __STDC_LIMIT_MACROS and __STDC_CONSTANT_MACROS are mentioned
@@ -33,6 +33,14 @@ static int comp_hashnodes (const void *, const void *);
 static int collect_ht_nodes (cpp_reader *, cpp_hashnode *, void *);
 static int write_defs (cpp_reader *, cpp_hashnode *, void *);
 static int save_macros (cpp_reader *, cpp_hashnode *, void *);
+static int fingerprint_macro (cpp_reader *, cpp_hashnode *, void *);
+static const struct cpp_macro_fingerprint *current_fingerprint (cpp_reader *);
+
+/* It's ok if this macro becomes undefined; see cpp_valid_state.  */
+#define CFI_ASM_MACRO "__GCC_HAVE_DWARF2_CFI_ASM"
+#define cfi_asm_node_p(HN) \
+  (NODE_LEN (HN) == sizeof (CFI_ASM_MACRO) - 1 \
+   && !memcmp (NODE_NAME (HN), CFI_ASM_MACRO, NODE_LEN (HN)))
 
 /* This structure represents a macro definition on disk.  */
 struct macrodef_struct
@@ -184,6 +192,44 @@ cpp_string_eq (const void *a_p, const void *b_p)
 	  && memcmp (a->text, b->text, a->len) == 0);
 }
 
+/* Add the definition of HN, if it is a macro that cpp_valid_state
+   requires to match, to the fingerprint FP_P.  Suitable for being
+   called by cpp_forall_identifiers.  */
+
+static int
+fingerprint_macro (cpp_reader *pfile, cpp_hashnode *hn, void *fp_p)
+{
+  struct cpp_macro_fingerprint *fp = (struct cpp_macro_fingerprint *) fp_p;
+  const unsigned char *defn;
+
+  if (hn->type != NT_MACRO || (hn->flags & NODE_BUILTIN)
+      || cfi_asm_node_p (hn))
+    return 1;
+
+  defn = cpp_macro_definition (pfile, hn);
+  fp->n_defs++;
+  fp->hash += hashmem (defn, ustrlen (defn));
+  return 1;
+}
+
+/* Return the fingerprint of the macros defined now.  It is computed
+   once for all the precompiled headers tried at one #include.  */
+
+static const struct cpp_macro_fingerprint *
+current_fingerprint (cpp_reader *r)
+{
+  if (!r->fingerprint_valid
+      || r->fingerprint_generation != r->macro_generation)
+    {
+      r->fingerprint.n_defs = 0;
+      r->fingerprint.hash = 0;
+      cpp_forall_identifiers (r, fingerprint_macro, &r->fingerprint);
+      r->fingerprint_generation = r->macro_generation;
+      r->fingerprint_valid = true;
+    }
+  return &r->fingerprint;
+}
+
 /* Save the current definitions of the cpp_reader for dependency
    checking purposes.  When writing a precompiled header, this should
    be called at the same point in the compilation as cpp_valid_state
@@ -198,7 +244,14 @@ cpp_save_state (cpp_reader *r, FILE *f)
 					    cpp_string_eq, NULL);
   cpp_forall_identifiers (r, save_idents, r->savedstate);
 
-  /* Write out the list of defined identifiers.  */
+  /* Write out a fingerprint of the defined macros, and then the list
+     of defined identifiers.  */
+  if (fwrite (current_fingerprint (r), sizeof (struct cpp_macro_fingerprint),
+	      1, f) != 1)
+    {
+      cpp_errno (r, CPP_DL_ERROR, "while writing precompiled header");
+      return -1;
+    }
   cpp_forall_identifiers (r, write_macdef, f);
 
   return 0;
@@ -426,6 +479,11 @@ collect_ht_nodes (cpp_reader *pfile ATTRIBUTE_UNUSED, cpp_hashnode *hn,
    - anything that was not defined then, but is defined now, was not
      used by the PCH.
 
+   The fingerprint of the macros defined then is compared first.  If
+   no more macros are defined now than then, the first condition can
+   only hold if the fingerprints agree, so most unusable files are
+   rejected without looking at each definition.
+
    NAME is used to print warnings if `warn_invalid_pch' is set in the
    reader's flags.
 */
@@ -441,6 +499,21 @@ cpp_valid_state (cpp_reader *r, const char *name, int fd)
   unsigned char *first, *last;
   unsigned int i;
   unsigned int counter;
+  struct cpp_macro_fingerprint fp;
+
+  if (read (fd, &fp, sizeof (fp)) != sizeof (fp))
+    goto error;
+
+  /* Go through the definitions one by one when asked to say which of
+     them is the problem.  */
+  if (!CPP_OPTION (r, preprocessed) && !CPP_OPTION (r, warn_invalid_pch))
+    {
+      const struct cpp_macro_fingerprint *cur = current_fingerprint (r);
+
+      if (cur->n_defs < fp.n_defs
+	  || (cur->n_defs == fp.n_defs && cur->hash != fp.hash))
+	goto fail;
+    }
 
   /* Read in the list of identifiers that must be defined
      Check that they are defined in the same way.  */
@@ -496,9 +569,7 @@ cpp_valid_state (cpp_reader *r, const char *name, int fd)
 	     definitions that take this macro into accout, to decide
 	     what asm to emit, won't issue .cfi directives when the
 	     compiler doesn't.  */
-	  if (!(h->flags & NODE_USED)
-	      && m.name_length == sizeof ("__GCC_HAVE_DWARF2_CFI_ASM") - 1
-	      && !memcmp (namebuf, "__GCC_HAVE_DWARF2_CFI_ASM", m.name_length))
+	  if (!(h->flags & NODE_USED) && cfi_asm_node_p (h))
 	    continue;
 
 	  if (CPP_OPTION (r, warn_invalid_pch))
@@ -698,6 +769,10 @@ cpp_read_state (cpp_reader *r, const char *name, FILE *f,
     s->n__VA_ARGS__     = cpp_lookup (r, DSC("__VA_ARGS__"));
   }
 
+  /* The identifiers have been replaced wholesale, so nothing memoized
+     about the old ones may be replayed.  */
+  _cpp_macro_changed (r, NULL);
+
   old_state = r->state;
   r->state.in_directive = 1;
   r->state.prevent_expansion = 1;
@@ -30,26 +30,18 @@ along with this program; see the file COPYING3.  If not see
    intrinsically how to calculate a hash value, and how to compare an
    existing entry with a potential new one.  */
 
-static unsigned int calc_hash (const unsigned char *, size_t);
 static void ht_expand (hash_table *);
 static double approx_sqrt (double);
 
 /* A deleted entry.  */
 #define DELETED ((hashnode) -1)
 
-/* Calculate the hash of the string STR of length LEN.  */
-
-static unsigned int
-calc_hash (const unsigned char *str, size_t len)
-{
-  size_t n = len;
-  unsigned int r = 0;
-
-  while (n--)
-    r = HT_HASHSTEP (r, *str++);
-
-  return HT_HASHFINISH (r, len);
-}
+/* The step between probes for HASH in a table of SIZEMASK + 1 slots.
+   It must be odd, so that every slot is eventually visited.  It is
+   taken from the high half of the hash, so that names colliding on
+   their first probe do not follow the same sequence.  */
+#define HT_PROBE_STEP(hash, sizemask) \
+  ((((hash) >> 16 | (hash) << 16) & (sizemask)) | 1)
 
 /* Initialize an identifier hashtable.  */
 
@@ -94,7 +86,7 @@ hashnode
 ht_lookup (hash_table *table, const unsigned char *str, size_t len,
 	   enum ht_lookup_option insert)
 {
-  return ht_lookup_with_hash (table, str, len, calc_hash (str, len),
+  return ht_lookup_with_hash (table, str, len, ht_calc_hash (str, len),
 			      insert);
 }
 
@@ -124,9 +116,7 @@ ht_lookup_with_hash (hash_table *table, const unsigned char *str,
 	       && !memcmp (HT_STR (node), str, len))
 	return node;
 
-      /* hash2 must be odd, so we're guaranteed to visit every possible
-	 location in the table during rehashing.  */
-      hash2 = ((hash * 17) & sizemask) | 1;
+      hash2 = HT_PROBE_STEP (hash, sizemask);
 
       for (;;)
 	{
@@ -203,7 +193,7 @@ ht_expand (hash_table *table)
 
 	if (nentries[index])
 	  {
-	    hash2 = ((hash * 17) & sizemask) | 1;
+	    hash2 = HT_PROBE_STEP (hash, sizemask);
 	    do
 	      {
 		index = (index + hash2) & sizemask;
@@ -0,0 +1,488 @@
+/* An open-addressing hash table probed a group of slots at a time.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+This file is part of the libiberty library.
+Libiberty is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+Libiberty is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Library General Public License for more details.
+
+You should have received a copy of the GNU Library General Public
+License along with libiberty; see the file COPYING.LIB.  If
+not, write to the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+Boston, MA 02110-1301, USA.  */
+
+/* The slots of the table are divided into groups of GROUPTAB_GROUP_SIZE.
+   The hash code of an element, shifted right by seven bits, selects the
+   group where its search starts; its low seven bits are stored in the
+   control byte of the slot the element occupies.  A search compares the
+   control bytes of a whole group with those seven bits, and only calls
+   the comparison function for the slots that match.  If the group also
+   has an empty slot, the search is over; otherwise it goes on with the
+   next group in a triangular sequence, which visits every group since
+   their number is a power of two.
+
+   With SSE2 a group is compared with two instructions; elsewhere, or
+   if GROUPTAB_NO_SSE2 is defined, a plain loop does the same.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+
+#include <stdio.h>
+
+#include "libiberty.h"
+#include "ansidecl.h"
+#include "grouptab.h"
+
+#if defined (__SSE2__) && defined (__GNUC__) && !defined (GROUPTAB_NO_SSE2)
+#include <emmintrin.h>
+#define GROUPTAB_SSE2
+#endif
+
+#ifndef CHAR_BIT
+#define CHAR_BIT 8
+#endif
+
+/* The table is expanded or cleaned of deleted slots when 7/8 of it is
+   in use, and left at most 7/16 full afterwards.  */
+#define GROUPTAB_FULL(N, SIZE) ((N) * 8 >= (SIZE) * 7)
+#define GROUPTAB_SPARSE(N, SIZE) ((N) * 16 < (SIZE) * 7)
+
+static grouptab_t grouptab_alloc (size_t, htab_hash, htab_eq, htab_del, int);
+static void grouptab_alloc_slots (grouptab_t, size_t, int);
+static void grouptab_expand (grouptab_t);
+
+/* Return a mask of the slots in the group starting at CONTROL whose
+   control byte is BYTE.  */
+
+static inline unsigned int
+group_match (const unsigned char *control, unsigned char byte)
+{
+#ifdef GROUPTAB_SSE2
+  __m128i group = _mm_loadu_si128 ((const __m128i *) control);
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (group,
+					    _mm_set1_epi8 ((char) byte)));
+#else
+  unsigned int mask = 0;
+  int i;
+
+  for (i = 0; i < GROUPTAB_GROUP_SIZE; i++)
+    if (control[i] == byte)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+/* Return a mask of the empty or deleted slots in the group starting at
+   CONTROL.  */
+
+static inline unsigned int
+group_match_free (const unsigned char *control)
+{
+#ifdef GROUPTAB_SSE2
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) control));
+#else
+  unsigned int mask = 0;
+  int i;
+
+  for (i = 0; i < GROUPTAB_GROUP_SIZE; i++)
+    if (control[i] & GROUPTAB_EMPTY)
+      mask |= 1u << i;
+  return mask;
+#endif
+}
+
+/* Hash the address P by the multiplicative method, keeping the most
+   significant bits of the product, which depend on every bit of P.  */
+
+hashval_t
+grouptab_hash_pointer (const void *p)
+{
+  size_t a;
+
+  if (sizeof (size_t) * CHAR_BIT >= 64)
+    a = ((size_t) 0x9e3779b9 << 16 << 16) | 0x7f4a7c15;
+  else
+    a = 0x9e3779b9;
+  return (hashval_t) ((a * (size_t) p) >> (sizeof (size_t) * CHAR_BIT - 32));
+}
+
+static inline hashval_t
+grouptab_hash (grouptab_t tab, const void *element)
+{
+  return tab->hash_f ? (*tab->hash_f) (element)
+		     : grouptab_hash_pointer (element);
+}
+
+/* Allocate SIZE empty slots for TAB, with values if MAP.  */
+
+static void
+grouptab_alloc_slots (grouptab_t tab, size_t size, int map)
+{
+  tab->size = size;
+  tab->entries = XCNEWVEC (void *, size);
+  tab->values = map ? XCNEWVEC (void *, size) : NULL;
+  tab->control = XNEWVEC (unsigned char, size);
+  memset (tab->control, GROUPTAB_EMPTY, size);
+}
+
+static grouptab_t
+grouptab_alloc (size_t size, htab_hash hash_f, htab_eq eq_f,
+		htab_del del_f, int map)
+{
+  grouptab_t tab = XCNEW (struct grouptab);
+  size_t n = GROUPTAB_GROUP_SIZE;
+
+  while (!GROUPTAB_SPARSE (size, n))
+    n *= 2;
+
+  tab->hash_f = hash_f;
+  tab->eq_f = eq_f;
+  tab->del_f = del_f;
+  grouptab_alloc_slots (tab, n, map);
+  return tab;
+}
+
+/* Create a table with room for SIZE elements.  HASH_F and EQ_F hash and
+   compare elements as for htab_create; if both are null, the elements
+   are pointers, hashed and compared by address.  DEL_F, if not null, is
+   called on every element removed from the table.  */
+
+grouptab_t
+grouptab_create (size_t size, htab_hash hash_f, htab_eq eq_f,
+		 htab_del del_f)
+{
+  return grouptab_alloc (size, hash_f, eq_f, del_f, 0);
+}
+
+/* Like grouptab_create, but keep a value for every element, which
+   GROUPTAB_SLOT_VALUE returns for the slot of the element.  */
+
+grouptab_t
+grouptab_create_map (size_t size, htab_hash hash_f, htab_eq eq_f,
+		     htab_del del_f)
+{
+  return grouptab_alloc (size, hash_f, eq_f, del_f, 1);
+}
+
+/* Free TAB and, through its cleanup function, its elements.  */
+
+void
+grouptab_delete (grouptab_t tab)
+{
+  size_t i;
+
+  if (tab->del_f)
+    for (i = 0; i < tab->size; i++)
+      if (tab->entries[i])
+	(*tab->del_f) (tab->entries[i]);
+
+  free (tab->entries);
+  free (tab->values);
+  free (tab->control);
+  free (tab);
+}
+
+/* Remove all the elements of TAB.  */
+
+void
+grouptab_empty (grouptab_t tab)
+{
+  size_t i;
+
+  if (tab->del_f)
+    for (i = 0; i < tab->size; i++)
+      if (tab->entries[i])
+	(*tab->del_f) (tab->entries[i]);
+
+  /* Instead of clearing megabytes, downsize the table.  */
+  if (tab->size > 1024 * 1024 / sizeof (void *))
+    {
+      int map = tab->values != NULL;
+
+      free (tab->entries);
+      free (tab->values);
+      free (tab->control);
+      grouptab_alloc_slots (tab, 1024 / sizeof (void *), map);
+    }
+  else
+    {
+      memset (tab->entries, 0, tab->size * sizeof (void *));
+      if (tab->values)
+	memset (tab->values, 0, tab->size * sizeof (void *));
+      memset (tab->control, GROUPTAB_EMPTY, tab->size);
+    }
+  tab->n_elements = 0;
+  tab->n_deleted = 0;
+}
+
+/* Return the index of a free slot of TAB for an element with hash code
+   HASH.  TAB must have no deleted slots.  */
+
+static size_t
+find_empty_slot (grouptab_t tab, hashval_t hash)
+{
+  size_t group_mask = tab->size / GROUPTAB_GROUP_SIZE - 1;
+  size_t group = (hash >> 7) & group_mask;
+  size_t step = 0;
+
+  for (;;)
+    {
+      size_t base = group * GROUPTAB_GROUP_SIZE;
+      unsigned int match = group_match (tab->control + base, GROUPTAB_EMPTY);
+
+      if (match)
+	return base + ffs ((int) match) - 1;
+      group = (group + ++step) & group_mask;
+    }
+}
+
+/* Rehash the elements of TAB into new slots, doubling them if that is
+   needed to leave TAB sparse, and dropping the deleted slots.  */
+
+static void
+grouptab_expand (grouptab_t tab)
+{
+  void **oentries = tab->entries;
+  void **ovalues = tab->values;
+  unsigned char *ocontrol = tab->control;
+  size_t osize = tab->size;
+  size_t nsize = GROUPTAB_GROUP_SIZE;
+  size_t i;
+
+  while (!GROUPTAB_SPARSE (tab->n_elements + 1, nsize))
+    nsize *= 2;
+
+  grouptab_alloc_slots (tab, nsize, ovalues != NULL);
+  for (i = 0; i < osize; i++)
+    if (!(ocontrol[i] & GROUPTAB_EMPTY))
+      {
+	hashval_t hash = grouptab_hash (tab, oentries[i]);
+	size_t slot = find_empty_slot (tab, hash);
+
+	tab->control[slot] = hash & 0x7f;
+	tab->entries[slot] = oentries[i];
+	if (ovalues)
+	  tab->values[slot] = ovalues[i];
+      }
+  tab->n_deleted = 0;
+
+  free (oentries);
+  free (ovalues);
+  free (ocontrol);
+}
+
+/* The body of grouptab_find_slot_with_hash.  POINTER_KEYS is constant
+   in each caller, so that the comparison is specialized to an equality
+   test of addresses for tables of pointers.  */
+
+static inline void **
+find_slot_1 (grouptab_t tab, const void *element, hashval_t hash,
+	     enum insert_option insert, int pointer_keys)
+{
+  size_t group_mask, group, step, free_slot;
+  unsigned char tag = hash & 0x7f;
+
+  if (insert == INSERT
+      && GROUPTAB_FULL (tab->n_elements + tab->n_deleted + 1, tab->size))
+    grouptab_expand (tab);
+
+  group_mask = tab->size / GROUPTAB_GROUP_SIZE - 1;
+  group = (hash >> 7) & group_mask;
+  step = 0;
+  free_slot = tab->size;
+  tab->searches++;
+
+  for (;;)
+    {
+      size_t base = group * GROUPTAB_GROUP_SIZE;
+      const unsigned char *control = tab->control + base;
+      unsigned int match = group_match (control, tag);
+
+      while (match)
+	{
+	  size_t slot = base + ffs ((int) match) - 1;
+	  void *entry = tab->entries[slot];
+
+	  if (pointer_keys ? entry == element
+	      : (*tab->eq_f) (entry, element))
+	    return &tab->entries[slot];
+	  match &= match - 1;
+	}
+
+      if (insert == INSERT && free_slot == tab->size)
+	{
+	  unsigned int free_match = group_match_free (control);
+	  if (free_match)
+	    free_slot = base + ffs ((int) free_match) - 1;
+	}
+
+      if (group_match (control, GROUPTAB_EMPTY))
+	break;
+
+      tab->collisions++;
+      group = (group + ++step) & group_mask;
+    }
+
+  if (insert == NO_INSERT)
+    return NULL;
+
+  if (tab->control[free_slot] == GROUPTAB_DELETED)
+    tab->n_deleted--;
+  tab->control[free_slot] = tag;
+  tab->n_elements++;
+  return &tab->entries[free_slot];
+}
+
+/* Return the slot of TAB that holds an element equal to ELEMENT, whose
+   hash code is HASH.  If there is none, return null if INSERT is
+   NO_INSERT, and otherwise a new null slot for ELEMENT, in which the
+   caller must store a non-null element before searching TAB again.  */
+
+void **
+grouptab_find_slot_with_hash (grouptab_t tab, const void *element,
+			      hashval_t hash, enum insert_option insert)
+{
+  if (tab->eq_f)
+    return find_slot_1 (tab, element, hash, insert, 0);
+  else
+    return find_slot_1 (tab, element, hash, insert, 1);
+}
+
+/* Like grouptab_find_slot_with_hash, but compute the hash code from
+   ELEMENT.  */
+
+void **
+grouptab_find_slot (grouptab_t tab, const void *element,
+		    enum insert_option insert)
+{
+  if (tab->eq_f)
+    return find_slot_1 (tab, element, (*tab->hash_f) (element), insert, 0);
+  else
+    return find_slot_1 (tab, element, grouptab_hash_pointer (element),
+			insert, 1);
+}
+
+/* Return the element of TAB equal to ELEMENT, whose hash code is HASH,
+   or null.  */
+
+void *
+grouptab_find_with_hash (grouptab_t tab, const void *element, hashval_t hash)
+{
+  void **slot = grouptab_find_slot_with_hash (tab, element, hash, NO_INSERT);
+  return slot ? *slot : NULL;
+}
+
+/* Like grouptab_find_with_hash, but compute the hash code from
+   ELEMENT.  */
+
+void *
+grouptab_find (grouptab_t tab, const void *element)
+{
+  void **slot = grouptab_find_slot (tab, element, NO_INSERT);
+  return slot ? *slot : NULL;
+}
+
+/* Remove the element in SLOT of TAB.  A slot whose group still has an
+   empty slot can become empty again, since no search has gone past that
+   group; otherwise it is marked deleted.  */
+
+void
+grouptab_clear_slot (grouptab_t tab, void **slot)
+{
+  size_t index = slot - tab->entries;
+  size_t base = index & ~(size_t) (GROUPTAB_GROUP_SIZE - 1);
+
+  if (tab->del_f)
+    (*tab->del_f) (*slot);
+  *slot = NULL;
+  if (tab->values)
+    tab->values[index] = NULL;
+
+  if (group_match (tab->control + base, GROUPTAB_EMPTY))
+    tab->control[index] = GROUPTAB_EMPTY;
+  else
+    {
+      tab->control[index] = GROUPTAB_DELETED;
+      tab->n_deleted++;
+    }
+  tab->n_elements--;
+}
+
+/* Remove the element of TAB equal to ELEMENT, whose hash code is HASH,
+   if there is one.  */
+
+void
+grouptab_remove_elt_with_hash (grouptab_t tab, void *element, hashval_t hash)
+{
+  void **slot = grouptab_find_slot_with_hash (tab, element, hash, NO_INSERT);
+  if (slot)
+    grouptab_clear_slot (tab, slot);
+}
+
+/* Like grouptab_remove_elt_with_hash, but compute the hash code from
+   ELEMENT.  */
+
+void
+grouptab_remove_elt (grouptab_t tab, void *element)
+{
+  grouptab_remove_elt_with_hash (tab, element, grouptab_hash (tab, element));
+}
+
+/* Call CALLBACK with the slot of each element of TAB and INFO, until it
+   returns zero.  CALLBACK may clear the slot it is passed.  */
+
+void
+grouptab_traverse (grouptab_t tab, htab_trav callback, void *info)
+{
+  size_t i;
+
+  for (i = 0; i < tab->size; i++)
+    if (tab->entries[i] && !(*callback) (&tab->entries[i], info))
+      break;
+}
+
+/* Return the number of slots of TAB.  */
+
+size_t
+grouptab_size (grouptab_t tab)
+{
+  return tab->size;
+}
+
+/* Return the number of elements of TAB.  */
+
+size_t
+grouptab_elements (grouptab_t tab)
+{
+  return tab->n_elements;
+}
+
+/* Return the average number of additional groups probed per search.  */
+
+double
+grouptab_collisions (grouptab_t tab)
+{
+  if (tab->searches == 0)
+    return 0.0;
+
+  return (double) tab->collisions / (double) tab->searches;
+}
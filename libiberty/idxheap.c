@@ -0,0 +1,259 @@
+/* An indexed binary heap datatype.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+This file is part of the libiberty library.
+Libiberty is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+Libiberty is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Library General Public License for more details.
+
+You should have received a copy of the GNU Library General Public
+License along with libiberty; see the file COPYING.LIB.  If
+not, write to the Free Software Foundation, Inc., 51 Franklin Street - Fifth Floor,
+Boston, MA 02110-1301, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#include "libiberty.h"
+#include "idxheap.h"
+
+#define IDXHEAP_PARENT(I) (((I) - 1) / 2)
+#define IDXHEAP_LEFT(I) (2 * (I) + 1)
+
+static idxnode_t idxheap_new_node (idxheap_t);
+static void idxheap_place (idxheap_t, size_t, struct idxheap_entry *);
+static size_t idxheap_sift_up (idxheap_t, size_t, idxheapkey_t);
+static size_t idxheap_sift_down (idxheap_t, size_t, idxheapkey_t);
+static void idxheap_remove (idxheap_t, size_t);
+
+/* Create a new indexed heap.  */
+idxheap_t
+idxheap_new (void)
+{
+  return (idxheap_t) xcalloc (1, sizeof (struct idxheap));
+}
+
+/* Return a free node of HEAP, making more of them if there are none.
+   Node zero is never used.  */
+static idxnode_t
+idxheap_new_node (idxheap_t heap)
+{
+  idxnode_t node;
+
+  if (heap->free_node == 0)
+    {
+      size_t old_alloc = heap->index_alloc;
+      size_t i;
+
+      heap->index_alloc = old_alloc ? old_alloc * 2 : 16;
+      heap->index = XRESIZEVEC (size_t, heap->index, heap->index_alloc);
+
+      /* Thread the new nodes onto the free list, lowest first.  */
+      for (i = heap->index_alloc - 1; i >= old_alloc && i > 0; i--)
+	{
+	  heap->index[i] = heap->free_node;
+	  heap->free_node = i;
+	}
+    }
+
+  node = heap->free_node;
+  heap->free_node = heap->index[node];
+  return node;
+}
+
+/* Store ENTRY at position I of HEAP and record where its node now is.  */
+static inline void
+idxheap_place (idxheap_t heap, size_t i, struct idxheap_entry *entry)
+{
+  heap->entries[i] = *entry;
+  heap->index[entry->node] = i;
+}
+
+/* Move the parents of position I of HEAP down for as long as their keys
+   are greater than KEY, and return the position left empty.  */
+static size_t
+idxheap_sift_up (idxheap_t heap, size_t i, idxheapkey_t key)
+{
+  while (i > 0)
+    {
+      size_t parent = IDXHEAP_PARENT (i);
+
+      if (heap->entries[parent].key <= key)
+	break;
+      idxheap_place (heap, i, &heap->entries[parent]);
+      i = parent;
+    }
+  return i;
+}
+
+/* Move the smaller child of position I of HEAP up for as long as its
+   key is less than KEY, and return the position left empty.  */
+static size_t
+idxheap_sift_down (idxheap_t heap, size_t i, idxheapkey_t key)
+{
+  size_t nodes = heap->nodes;
+  size_t child;
+
+  while ((child = IDXHEAP_LEFT (i)) < nodes)
+    {
+      if (child + 1 < nodes
+	  && heap->entries[child + 1].key < heap->entries[child].key)
+	child++;
+      if (heap->entries[child].key >= key)
+	break;
+      idxheap_place (heap, i, &heap->entries[child]);
+      i = child;
+    }
+  return i;
+}
+
+/* Insert DATA, with key KEY, into HEAP.  */
+idxnode_t
+idxheap_insert (idxheap_t heap, idxheapkey_t key, void *data)
+{
+  struct idxheap_entry entry;
+  size_t i;
+
+  if (heap->nodes == heap->alloc)
+    {
+      heap->alloc = heap->alloc ? heap->alloc * 2 : 16;
+      heap->entries = XRESIZEVEC (struct idxheap_entry, heap->entries,
+				  heap->alloc);
+    }
+
+  entry.key = key;
+  entry.data = data;
+  entry.node = idxheap_new_node (heap);
+
+  i = idxheap_sift_up (heap, heap->nodes++, key);
+  idxheap_place (heap, i, &entry);
+  return entry.node;
+}
+
+/* Return nonzero if no elements left in HEAP.  */
+int
+idxheap_empty (idxheap_t heap)
+{
+  return heap->nodes == 0;
+}
+
+/* Return the minimum key in HEAP.  */
+idxheapkey_t
+idxheap_min_key (idxheap_t heap)
+{
+  /* If there is no min, we can't easily return it.  */
+  if (heap->nodes == 0)
+    return 0;
+  return heap->entries[0].key;
+}
+
+/* Return the data of the element with the minimum key in HEAP.  */
+void *
+idxheap_min (idxheap_t heap)
+{
+  /* If there is no min, we can't easily return it.  */
+  if (heap->nodes == 0)
+    return NULL;
+  return heap->entries[0].data;
+}
+
+/* Remove the element at position I of HEAP and free its node.  */
+static void
+idxheap_remove (idxheap_t heap, size_t i)
+{
+  idxnode_t node = heap->entries[i].node;
+
+  heap->index[node] = heap->free_node;
+  heap->free_node = node;
+
+  /* Put the last element in the hole, moving it whichever way its key
+     requires.  */
+  if (i != --heap->nodes)
+    {
+      struct idxheap_entry last = heap->entries[heap->nodes];
+      size_t j = idxheap_sift_up (heap, i, last.key);
+
+      if (j == i)
+	j = idxheap_sift_down (heap, i, last.key);
+      idxheap_place (heap, j, &last);
+    }
+}
+
+/* Extract the data of the minimum node from HEAP.  */
+void *
+idxheap_extract_min (idxheap_t heap)
+{
+  void *data;
+
+  if (heap->nodes == 0)
+    return NULL;
+
+  data = heap->entries[0].data;
+  idxheap_remove (heap, 0);
+  return data;
+}
+
+/* Return the key of NODE in HEAP.  */
+idxheapkey_t
+idxheap_key (idxheap_t heap, idxnode_t node)
+{
+  return heap->entries[heap->index[node]].key;
+}
+
+/* Return the data of NODE in HEAP.  */
+void *
+idxheap_data (idxheap_t heap, idxnode_t node)
+{
+  return heap->entries[heap->index[node]].data;
+}
+
+/* Change the key of NODE in HEAP to KEY, which may be greater or less
+   than the old one, and return the old key.  */
+idxheapkey_t
+idxheap_replace_key (idxheap_t heap, idxnode_t node, idxheapkey_t key)
+{
+  size_t i = heap->index[node];
+  struct idxheap_entry entry = heap->entries[i];
+  idxheapkey_t okey = entry.key;
+  size_t j;
+
+  if (key == okey)
+    return okey;
+
+  entry.key = key;
+  if (key < okey)
+    j = idxheap_sift_up (heap, i, key);
+  else
+    j = idxheap_sift_down (heap, i, key);
+  idxheap_place (heap, j, &entry);
+  return okey;
+}
+
+/* Delete NODE from HEAP and return its data.  */
+void *
+idxheap_delete_node (idxheap_t heap, idxnode_t node)
+{
+  size_t i = heap->index[node];
+  void *data = heap->entries[i].data;
+
+  idxheap_remove (heap, i);
+  return data;
+}
+
+/* Delete HEAP.  */
+void
+idxheap_delete (idxheap_t heap)
+{
+  free (heap->entries);
+  free (heap->index);
+  free (heap);
+}
@@ -70,6 +70,16 @@ extern int errno;
                lib$get_current_invo_context(decc$$get_vfork_jmpbuf()) : -1)
 #endif /* VMS */
 
+/* Where posix_spawn is available, use it to start children.  It can
+   avoid copying the parent's address space even where vfork is just
+   fork, and it does not run any of our code in the child.  */
+
+#if defined (HAVE_SPAWN_H) && defined (HAVE_POSIX_SPAWN) \
+    && defined (HAVE_POSIX_SPAWNP) && !defined (VMS)
+#define USE_POSIX_SPAWN
+#include <spawn.h>
+#endif
+
 
 /* File mode to use for private and world-readable files.  */
 
@@ -355,6 +365,86 @@ pex_child_error (struct pex_obj *obj, const char *executable,
 
 extern char **environ;
 
+#ifdef USE_POSIX_SPAWN
+
+/* Start EXECUTABLE with posix_spawn, giving it the same descriptors
+   that the child code of pex_unix_exec_child would set up.  Return the
+   process ID, or -1 with *ERRMSG and *ERR set.  */
+
+static pid_t
+pex_unix_spawn (int flags, const char *executable, char * const * argv,
+		char * const * env, int in, int out, int errdes, int toclose,
+		const char **errmsg, int *err)
+{
+  posix_spawn_file_actions_t actions;
+  int sleep_interval;
+  int retries;
+  pid_t pid;
+  int ret;
+
+  ret = posix_spawn_file_actions_init (&actions);
+  if (ret != 0)
+    {
+      *err = ret;
+      *errmsg = "posix_spawn_file_actions_init";
+      return (pid_t) -1;
+    }
+
+  if (ret == 0 && in != STDIN_FILE_NO)
+    ret = posix_spawn_file_actions_adddup2 (&actions, in, STDIN_FILE_NO);
+  if (ret == 0 && in != STDIN_FILE_NO)
+    ret = posix_spawn_file_actions_addclose (&actions, in);
+  if (ret == 0 && out != STDOUT_FILE_NO)
+    ret = posix_spawn_file_actions_adddup2 (&actions, out, STDOUT_FILE_NO);
+  if (ret == 0 && out != STDOUT_FILE_NO)
+    ret = posix_spawn_file_actions_addclose (&actions, out);
+  if (ret == 0 && errdes != STDERR_FILE_NO)
+    ret = posix_spawn_file_actions_adddup2 (&actions, errdes,
+					    STDERR_FILE_NO);
+  if (ret == 0 && errdes != STDERR_FILE_NO)
+    ret = posix_spawn_file_actions_addclose (&actions, errdes);
+  if (ret == 0 && toclose >= 0)
+    ret = posix_spawn_file_actions_addclose (&actions, toclose);
+  if (ret == 0 && (flags & PEX_STDERR_TO_STDOUT) != 0)
+    ret = posix_spawn_file_actions_adddup2 (&actions, STDOUT_FILE_NO,
+					    STDERR_FILE_NO);
+  if (ret != 0)
+    {
+      posix_spawn_file_actions_destroy (&actions);
+      *err = ret;
+      *errmsg = "posix_spawn_file_actions";
+      return (pid_t) -1;
+    }
+
+  if (env == NULL)
+    env = environ;
+
+  sleep_interval = 1;
+  for (retries = 0; retries < 4; ++retries)
+    {
+      if ((flags & PEX_SEARCH) != 0)
+	ret = posix_spawnp (&pid, executable, &actions, NULL, argv, env);
+      else
+	ret = posix_spawn (&pid, executable, &actions, NULL, argv, env);
+      if (ret != EAGAIN)
+	break;
+      sleep (sleep_interval);
+      sleep_interval *= 2;
+    }
+
+  posix_spawn_file_actions_destroy (&actions);
+
+  if (ret != 0)
+    {
+      *err = ret;
+      *errmsg = (flags & PEX_SEARCH) != 0 ? "posix_spawnp" : "posix_spawn";
+      return (pid_t) -1;
+    }
+  return pid;
+}
+
+#endif /* USE_POSIX_SPAWN */
+
 static pid_t
 pex_unix_exec_child (struct pex_obj *obj, int flags, const char *executable,
 		     char * const * argv, char * const * env,
@@ -362,21 +452,31 @@ pex_unix_exec_child (struct pex_obj *obj, int flags, const char *executable,
 		     int toclose, const char **errmsg, int *err)
 {
   pid_t pid;
-
   /* We declare these to be volatile to avoid warnings from gcc about
      them being clobbered by vfork.  */
   volatile int sleep_interval;
   volatile int retries;
 
-  sleep_interval = 1;
-  pid = -1;
-  for (retries = 0; retries < 4; ++retries)
+#ifdef USE_POSIX_SPAWN
+  /* If posix_spawn fails, for instance because EXECUTABLE cannot be
+     run, go through vfork so that the child reports the error as it
+     always has, and the caller sees a failed child rather than a
+     failure to start one.  */
+  pid = pex_unix_spawn (flags, executable, argv, env, in, out, errdes,
+			toclose, errmsg, err);
+  if (pid < 0)
+#endif
     {
-      pid = vfork ();
-      if (pid >= 0)
-	break;
-      sleep (sleep_interval);
-      sleep_interval *= 2;
+      sleep_interval = 1;
+      pid = -1;
+      for (retries = 0; retries < 4; ++retries)
+	{
+	  pid = vfork ();
+	  if (pid >= 0)
+	    break;
+	  sleep (sleep_interval);
+	  sleep_interval *= 2;
+	}
     }
 
   switch (pid)
@@ -0,0 +1,297 @@
+/* grouptab test program.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+   This file is part of the libiberty library, which is part of GCC.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   In addition to the permissions in the GNU General Public License, the
+   Free Software Foundation gives you unlimited permission to link the
+   compiled version of this file into combinations with other programs,
+   and to distribute those combinations without any restriction coming
+   from the use of this file.  (The General Public License restrictions
+   do apply in other respects; for example, they cover modification of
+   the file, and distribution when not linked into a combined
+   executable.)
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This file is built twice: once linked with libiberty.a, and once
+   with GROUPTAB_NO_SSE2 defined and grouptab.c compiled along with it,
+   so that the group searches are done both ways on hosts with SSE2.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "libiberty.h"
+#include "grouptab.h"
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifndef EXIT_SUCCESS
+#define EXIT_SUCCESS 0
+#endif
+
+#ifndef EXIT_FAILURE
+#define EXIT_FAILURE 1
+#endif
+
+#ifdef GROUPTAB_NO_SSE2
+#define TEST_NAME "test-grouptab-plain"
+#else
+#define TEST_NAME "test-grouptab"
+#endif
+
+/* Enough elements to expand a table several times.  */
+#define N_ITEMS 1000
+
+static int fails;
+
+#define CHECK(COND) check ((COND) != 0, #COND, __LINE__)
+
+static void
+check (int ok, const char *what, int line)
+{
+  if (!ok)
+    {
+      printf ("FAIL: %s:%d: %s\n", TEST_NAME, line, what);
+      fails++;
+    }
+}
+
+/* Elements of the tables with a hash function.  The hash code keeps
+   the low bits of the key, with no bits above the seventh, so every
+   element is first looked for in the same group and many of them
+   share a control byte.  */
+
+struct item
+{
+  int key;
+  int deleted;
+};
+
+static struct item items[N_ITEMS];
+
+static hashval_t
+item_hash (const void *p)
+{
+  return ((const struct item *) p)->key & 3;
+}
+
+static int
+item_eq (const void *p1, const void *p2)
+{
+  return ((const struct item *) p1)->key == ((const struct item *) p2)->key;
+}
+
+static void
+item_del (void *p)
+{
+  ((struct item *) p)->deleted++;
+}
+
+static int
+count_elements (void **slot ATTRIBUTE_UNUSED, void *info)
+{
+  (*(size_t *) info)++;
+  return 1;
+}
+
+/* Clear the slots of the elements with odd keys of the table INFO.  */
+
+static int
+clear_odd (void **slot, void *info)
+{
+  if (((struct item *) *slot)->key & 1)
+    grouptab_clear_slot ((grouptab_t) info, slot);
+  return 1;
+}
+
+static void
+insert (grouptab_t tab, void *element)
+{
+  void **slot = grouptab_find_slot (tab, element, INSERT);
+
+  CHECK (slot != NULL && *slot == NULL);
+  *slot = element;
+}
+
+static size_t
+traversed_elements (grouptab_t tab)
+{
+  size_t n = 0;
+
+  grouptab_traverse (tab, count_elements, &n);
+  return n;
+}
+
+/* Insert, find and remove the addresses of ITEMS in a table of
+   pointers.  */
+
+static void
+test_pointers (void)
+{
+  grouptab_t tab = grouptab_create (1, NULL, NULL, NULL);
+  int i;
+
+  for (i = 0; i < N_ITEMS; i++)
+    insert (tab, &items[i]);
+  CHECK (grouptab_elements (tab) == N_ITEMS);
+  CHECK (grouptab_size (tab) % GROUPTAB_GROUP_SIZE == 0);
+  CHECK ((grouptab_size (tab) & (grouptab_size (tab) - 1)) == 0);
+  CHECK (traversed_elements (tab) == N_ITEMS);
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      CHECK (grouptab_find (tab, &items[i]) == &items[i]);
+      CHECK (*grouptab_find_slot (tab, &items[i], INSERT) == &items[i]);
+    }
+  CHECK (grouptab_elements (tab) == N_ITEMS);
+  CHECK (grouptab_find (tab, &fails) == NULL);
+
+  for (i = 0; i < N_ITEMS; i += 2)
+    grouptab_remove_elt (tab, &items[i]);
+  CHECK (grouptab_elements (tab) == N_ITEMS / 2);
+  for (i = 0; i < N_ITEMS; i++)
+    CHECK (grouptab_find (tab, &items[i]) == (i & 1 ? &items[i] : NULL));
+
+  for (i = 0; i < N_ITEMS; i += 2)
+    insert (tab, &items[i]);
+  CHECK (grouptab_elements (tab) == N_ITEMS);
+  for (i = 0; i < N_ITEMS; i++)
+    CHECK (grouptab_find_with_hash (tab, &items[i],
+				    grouptab_hash_pointer (&items[i]))
+	   == &items[i]);
+
+  grouptab_empty (tab);
+  CHECK (grouptab_elements (tab) == 0);
+  CHECK (traversed_elements (tab) == 0);
+  CHECK (grouptab_find (tab, &items[0]) == NULL);
+  grouptab_delete (tab);
+}
+
+/* Do the same with elements that all collide, and check that the
+   cleanup function is called once for every element removed.  */
+
+static void
+test_collisions (void)
+{
+  grouptab_t tab = grouptab_create (1, item_hash, item_eq, item_del);
+  struct item probe;
+  int i;
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      items[i].key = i;
+      items[i].deleted = 0;
+      insert (tab, &items[i]);
+    }
+  CHECK (grouptab_elements (tab) == N_ITEMS);
+  CHECK (grouptab_collisions (tab) > 0);
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      probe.key = i;
+      CHECK (grouptab_find (tab, &probe) == &items[i]);
+    }
+  probe.key = N_ITEMS;
+  CHECK (grouptab_find (tab, &probe) == NULL);
+
+  /* Removing elements from full groups leaves deleted slots, which
+     must neither end a search nor hold a second copy of an element.  */
+  grouptab_traverse (tab, clear_odd, tab);
+  CHECK (grouptab_elements (tab) == N_ITEMS / 2);
+  CHECK (tab->n_deleted > 0);
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      probe.key = i;
+      CHECK (grouptab_find (tab, &probe) == (i & 1 ? NULL : &items[i]));
+      CHECK (items[i].deleted == (i & 1));
+    }
+
+  for (i = 1; i < N_ITEMS; i += 2)
+    insert (tab, &items[i]);
+  CHECK (grouptab_elements (tab) == N_ITEMS);
+  CHECK (traversed_elements (tab) == N_ITEMS);
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      probe.key = i;
+      CHECK (grouptab_find (tab, &probe) == &items[i]);
+    }
+
+  grouptab_delete (tab);
+  for (i = 0; i < N_ITEMS; i++)
+    CHECK (items[i].deleted == 1 + (i & 1));
+}
+
+/* Check that the values of a map follow their elements when the table
+   is expanded and when elements are removed.  */
+
+static void
+test_map (void)
+{
+  grouptab_t tab = grouptab_create_map (1, item_hash, item_eq, NULL);
+  struct item probe;
+  void **slot;
+  int i;
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      items[i].key = i;
+      slot = grouptab_find_slot (tab, &items[i], INSERT);
+      CHECK (*slot == NULL && *GROUPTAB_SLOT_VALUE (tab, slot) == NULL);
+      *slot = &items[i];
+      *GROUPTAB_SLOT_VALUE (tab, slot) = &items[N_ITEMS - 1 - i];
+    }
+
+  for (i = 0; i < N_ITEMS; i += 3)
+    grouptab_remove_elt (tab, &items[i]);
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      probe.key = i;
+      slot = grouptab_find_slot (tab, &probe, NO_INSERT);
+      if (i % 3 == 0)
+	CHECK (slot == NULL);
+      else
+	CHECK (slot != NULL
+	       && *GROUPTAB_SLOT_VALUE (tab, slot) == &items[N_ITEMS - 1 - i]);
+    }
+
+  slot = grouptab_find_slot (tab, &items[0], INSERT);
+  CHECK (*slot == NULL && *GROUPTAB_SLOT_VALUE (tab, slot) == NULL);
+  *slot = &items[0];
+
+  grouptab_empty (tab);
+  CHECK (grouptab_elements (tab) == 0);
+  grouptab_delete (tab);
+}
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv ATTRIBUTE_UNUSED)
+{
+  test_pointers ();
+  test_collisions ();
+  test_map ();
+
+  if (fails)
+    exit (EXIT_FAILURE);
+  printf ("PASS: %s\n", TEST_NAME);
+  exit (EXIT_SUCCESS);
+}
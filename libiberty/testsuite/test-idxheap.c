@@ -0,0 +1,239 @@
+/* idxheap test program.
+   Copyright (C) 2009 Free Software Foundation, Inc.
+
+   This file is part of the libiberty library, which is part of GCC.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   In addition to the permissions in the GNU General Public License, the
+   Free Software Foundation gives you unlimited permission to link the
+   compiled version of this file into combinations with other programs,
+   and to distribute those combinations without any restriction coming
+   from the use of this file.  (The General Public License restrictions
+   do apply in other respects; for example, they cover modification of
+   the file, and distribution when not linked into a combined
+   executable.)
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "libiberty.h"
+#include "idxheap.h"
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#ifndef EXIT_SUCCESS
+#define EXIT_SUCCESS 0
+#endif
+
+#ifndef EXIT_FAILURE
+#define EXIT_FAILURE 1
+#endif
+
+/* Enough elements to grow the arrays of a heap several times.  */
+#define N_ITEMS 300
+
+static int fails;
+
+#define CHECK(COND) check ((COND) != 0, #COND, __LINE__)
+
+static void
+check (int ok, const char *what, int line)
+{
+  if (!ok)
+    {
+      printf ("FAIL: test-idxheap:%d: %s\n", line, what);
+      fails++;
+    }
+}
+
+/* The elements, their keys and their nodes, or zero for those not in
+   the heap.  */
+
+static int items[N_ITEMS];
+static idxheapkey_t keys[N_ITEMS];
+static idxnode_t nodes[N_ITEMS];
+
+/* A linear congruential generator, so that the test is the same
+   everywhere.  */
+
+static unsigned long seed = 1;
+
+static long
+next_random (long limit)
+{
+  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+  return (long) (seed >> 8) % limit;
+}
+
+/* Check that the data and key of every node of HEAP are those
+   recorded for it.  */
+
+static void
+check_nodes (idxheap_t heap)
+{
+  int i;
+
+  for (i = 0; i < N_ITEMS; i++)
+    if (nodes[i])
+      {
+	CHECK (idxheap_data (heap, nodes[i]) == &items[i]);
+	CHECK (idxheap_key (heap, nodes[i]) == keys[i]);
+      }
+}
+
+/* Extract the elements of HEAP, checking that they come out in order
+   of their keys and that each is one still recorded as in the heap.  */
+
+static void
+drain (idxheap_t heap)
+{
+  idxheapkey_t last = 0;
+  int first = 1;
+  int i;
+
+  while (!idxheap_empty (heap))
+    {
+      idxheapkey_t key = idxheap_min_key (heap);
+      int *item = (int *) idxheap_min (heap);
+
+      CHECK (idxheap_extract_min (heap) == item);
+      i = item - items;
+      CHECK (first || key >= last);
+      CHECK (nodes[i] != 0 && keys[i] == key);
+      nodes[i] = 0;
+      last = key;
+      first = 0;
+    }
+
+  for (i = 0; i < N_ITEMS; i++)
+    CHECK (nodes[i] == 0);
+  CHECK (idxheap_extract_min (heap) == NULL);
+  CHECK (idxheap_min (heap) == NULL);
+}
+
+/* Insert ITEMS with random keys, change the keys of some of them up
+   and of others down, delete some, and check the order in which the
+   rest come out.  */
+
+static void
+test_keys (void)
+{
+  idxheap_t heap = idxheap_new ();
+  int i, j;
+
+  CHECK (idxheap_empty (heap));
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      keys[i] = next_random (1000);
+      nodes[i] = idxheap_insert (heap, keys[i], &items[i]);
+      CHECK (nodes[i] != 0);
+      for (j = 0; j < i; j++)
+	CHECK (nodes[j] != nodes[i]);
+    }
+  CHECK (!idxheap_empty (heap));
+  check_nodes (heap);
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      idxheapkey_t key;
+
+      switch (i % 3)
+	{
+	case 0:
+	  key = keys[i] - 1 - next_random (1000);
+	  break;
+	case 1:
+	  key = keys[i] + 1 + next_random (1000);
+	  break;
+	default:
+	  key = keys[i];
+	  break;
+	}
+      CHECK (idxheap_replace_key (heap, nodes[i], key) == keys[i]);
+      keys[i] = key;
+    }
+  check_nodes (heap);
+
+  for (i = 0; i < N_ITEMS; i += 4)
+    {
+      CHECK (idxheap_delete_node (heap, nodes[i]) == &items[i]);
+      nodes[i] = 0;
+    }
+  check_nodes (heap);
+
+  /* The minimum must follow the keys as they change.  */
+  for (i = 1; i < N_ITEMS; i += 4)
+    {
+      keys[i] = -2000 - i;
+      idxheap_replace_key (heap, nodes[i], keys[i]);
+      CHECK (idxheap_min (heap) == &items[i]);
+      CHECK (idxheap_min_key (heap) == keys[i]);
+    }
+
+  drain (heap);
+  idxheap_delete (heap);
+}
+
+/* Check that nodes are handed out from the lowest, and that freed
+   ones are reused, the last freed first, before new ones are made.  */
+
+static void
+test_free_list (void)
+{
+  idxheap_t heap = idxheap_new ();
+  int i;
+
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      keys[i] = i;
+      nodes[i] = idxheap_insert (heap, keys[i], &items[i]);
+      CHECK (nodes[i] == (idxnode_t) i + 1);
+    }
+
+  CHECK (idxheap_extract_min (heap) == &items[0]);
+  CHECK (idxheap_delete_node (heap, nodes[100]) == &items[100]);
+  CHECK (idxheap_delete_node (heap, nodes[200]) == &items[200]);
+
+  CHECK (idxheap_insert (heap, keys[200], &items[200]) == nodes[200]);
+  CHECK (idxheap_insert (heap, keys[100], &items[100]) == nodes[100]);
+  CHECK (idxheap_insert (heap, keys[0], &items[0]) == nodes[0]);
+  CHECK (idxheap_insert (heap, N_ITEMS, &fails) == (idxnode_t) N_ITEMS + 1);
+  check_nodes (heap);
+
+  CHECK (idxheap_extract_min (heap) == &items[0]);
+  nodes[0] = 0;
+  for (i = 1; i < N_ITEMS; i++)
+    CHECK (idxheap_extract_min (heap) == &items[i]);
+  CHECK (idxheap_extract_min (heap) == &fails);
+  CHECK (idxheap_empty (heap));
+  idxheap_delete (heap);
+}
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv ATTRIBUTE_UNUSED)
+{
+  test_keys ();
+  test_free_list ();
+
+  if (fails)
+    exit (EXIT_FAILURE);
+  printf ("PASS: test-idxheap\n");
+  exit (EXIT_SUCCESS);
+}